@@ -0,0 +1,61 @@
+#ifndef __BATCH_RUNNER_H__
+#define __BATCH_RUNNER_H__
+
+#include "Bus.hpp"
+#include "Cartridge.hpp"
+#include "PPU.hpp"
+#include "ThreadPool.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Steps many independent consoles of one game in parallel
+ *
+ * Every instance gets its own clone of the cartridge, so all of them share
+ * the one ROM image. Instances render straight into their slice of one
+ * contiguous batch of screens, and copy their RAM into another, so a step
+ * leaves all observations side by side without any gathering.
+ */
+class BatchRunner final {
+public:
+  using Input = std::array<uint8_t, 2>; // controller ports, as Bus
+
+public:
+  BatchRunner(const Cartridge &cartridge, size_t instances,
+              size_t threads = std::thread::hardware_concurrency(),
+              PPU::PixelFormat format = PPU::PixelFormat::Index);
+
+  auto get_instance_count() const -> size_t;
+  auto get_instance(size_t i) -> Bus &;
+
+  auto reset() -> void;
+  // runs frames on every instance with its own input; only the last frame
+  // is drawn, and only if is_shown
+  auto step(const std::vector<Input> &inputs, uint32_t frames = 1,
+            bool is_shown = true) -> void;
+
+  // ScreenWidth * ScreenHeight pixels per instance in the batch's pixel
+  // format, one instance after the other get_screen_stride() bytes apart
+  auto get_screens() const -> const uint8_t *;
+  auto get_screen_stride() const -> size_t;
+  // the 2kB of CPU RAM of every instance, one after the other
+  auto get_ram() const -> const uint8_t *;
+
+private:
+  static constexpr size_t ScreenSize = PPU::ScreenWidth * PPU::ScreenHeight;
+  static constexpr size_t RamSize = 2048;
+
+  std::vector<std::unique_ptr<Bus>> m_instances;
+  // whole pixels for the 4-byte formats, and four indexed pixels each
+  std::vector<uint32_t> m_screens;
+  size_t m_screen_stride;
+  std::vector<uint8_t> m_ram;
+  ThreadPool m_pool;
+};
+
+#endif // __BATCH_RUNNER_H__
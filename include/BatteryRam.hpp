@@ -0,0 +1,68 @@
+#ifndef __BATTERY_RAM_H__
+#define __BATTERY_RAM_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Battery-backed cartridge RAM kept in a save file
+ *
+ * The file is mapped shared, so the game's writes are plain stores into
+ * the page cache and the emulation thread never touches the file itself.
+ * A background thread writes the dirty pages out every FlushInterval, and
+ * once more when the RAM is released, so a crash loses at most the last
+ * interval of progress. Frames that are thrown away afterwards run with the
+ * RAM detached, mapped privately at the same address, so their writes
+ * never reach the file.
+ */
+class BatteryRam final {
+public:
+  static constexpr std::chrono::milliseconds FlushInterval{2000};
+
+public:
+  BatteryRam(const BatteryRam &) = delete;
+  auto operator=(const BatteryRam &) -> BatteryRam & = delete;
+  ~BatteryRam();
+
+  // maps size bytes of the file, creating it zero-filled or growing it
+  // when shorter; nullptr when it cannot be opened or mapped
+  static auto open(const std::string &fname, size_t size)
+      -> std::unique_ptr<BatteryRam>;
+
+  auto data() -> uint8_t * { return m_data; }
+  auto size() const -> size_t { return m_size; }
+
+  // writes the dirty pages out and waits until they are on disk
+  auto flush() -> bool;
+
+  // while detached, writes land in a private copy of the file; attaching
+  // drops them and brings back the file as it was. data() stays put
+  auto detach() -> bool;
+  auto attach() -> bool;
+
+private:
+  BatteryRam(int fd, uint8_t *data, size_t size);
+
+  auto remap(int flags) -> bool;
+
+  auto run_flusher() -> void;
+
+private:
+  int m_fd;
+  uint8_t *m_data;
+  size_t m_size;
+  bool m_is_detached = false;
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  bool m_quit = false;
+  std::thread m_flusher;
+};
+
+#endif // __BATTERY_RAM_H__
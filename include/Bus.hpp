@@ -1,38 +1,63 @@
-#ifndef __BUS_H__
-#define __BUS_H__
-
-#include "CPU.hpp"
-#include "Cartridge.hpp"
-#include "PPU.hpp"
-
-#include <array>
-#include <cstdint>
-#include <memory>
-
-class Cartridge;
-class CPU;
-class PPU;
-
-class Bus final {
-public:
-  std::unique_ptr<CPU> m_cpu;
-  std::unique_ptr<PPU> m_ppu;
-  std::shared_ptr<Cartridge> m_cartridge;
-  std::array<uint8_t, 2048> m_cpu_ram; // 2kB
-
-public:
-  Bus();
-  ~Bus();
-
-  auto write_cpu(uint16_t address, uint8_t data) -> void;
-  auto read_cpu(uint16_t address) -> uint8_t;
-
-  auto insert_cartridge(const std::shared_ptr<Cartridge> &cartridge) -> void;
-  auto reset() -> void;
-  auto clock() -> void;
-
-private:
-  uint32_t m_system_clock_counter{};
-};
-
+#ifndef __BUS_H__
+#define __BUS_H__
+
+#include "CPU.hpp"
+#include "Cartridge.hpp"
+#include "PPU.hpp"
+#include "SaveState.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+class Cartridge;
+class CPU;
+class PPU;
+
+class Bus final {
+public:
+  std::unique_ptr<CPU> m_cpu;
+  std::unique_ptr<PPU> m_ppu;
+  std::shared_ptr<Cartridge> m_cartridge;
+  std::array<uint8_t, 2048> m_cpu_ram; // 2kB
+  // buttons held on each controller port, one bit per button as the NES
+  // reads them: A, B, Select, Start, Up, Down, Left, Right from bit 7 down
+  std::array<uint8_t, 2> m_controller;
+
+public:
+  Bus();
+  ~Bus();
+
+  auto write_cpu(uint16_t address, uint8_t data) -> void;
+  // read-only reads, e.g. by the disassembler, leave registers untouched
+  auto read_cpu(uint16_t address, bool is_read_only = false) -> uint8_t;
+
+  auto insert_cartridge(const std::shared_ptr<Cartridge> &cartridge) -> void;
+  // the reset button: CPU and PPU only, memory and the cartridge keep what
+  // they hold
+  auto reset() -> void;
+  // a power cycle, which leaves nothing over from what ran before but
+  // battery RAM
+  auto power_on() -> void;
+  auto clock() -> void;
+
+  // snapshots of the whole console; loading fails for snapshots of another
+  // version or another game and leaves the console untouched
+  auto save_state(SaveState &state) const -> void;
+  auto load_state(const SaveState &state) -> bool;
+
+private:
+  auto dma_oam(uint8_t page) -> void;
+
+private:
+  uint32_t m_system_clock_counter{};
+  // CPU cycles left before the CPU resumes after an OAM DMA
+  uint16_t m_dma_stall_cycles{};
+  // controller shift registers, reloaded from m_controller while strobed
+  std::array<uint8_t, 2> m_controller_shift{};
+  bool m_controller_strobe{};
+  // the cartridge raised IRQ and has not been seen to drop it yet
+  bool m_is_irq_pending{};
+};
+
 #endif // __BUS_H__
\ No newline at end of file
@@ -1,49 +1,127 @@
-#ifndef __CARTRIDGE_H__
-#define __CARTRIDGE_H__
-
-#include "Mappers.hpp"
-
-#include <array>
-#include <cstdint>
-#include <memory>
-#include <string>
-#include <vector>
-
-class Cartridge {
-private:
-  struct Header {
-    uint8_t prg_rom_chunks;
-    uint8_t chr_rom_chunks;
-    uint8_t mapper_1;
-    uint8_t mapper_2;
-    uint8_t prg_ram_size;
-    uint8_t tv_system_1;
-    uint8_t tv_system_2;
-
-    std::array<char, 5> unused;
-  } header;
-
-public:
-  Cartridge(const std::string &fname);
-  ~Cartridge() = default;
-
-  auto read_cpu(uint16_t address, uint8_t &data) -> bool;
-  auto write_cpu(uint16_t address, uint8_t data) -> bool;
-
-  auto read_ppu(uint16_t address, uint8_t &data) -> bool;
-  auto write_ppu(uint16_t address, uint8_t data) -> bool;
-
-  auto is_valid_image() -> bool;
-
-private:
-  std::shared_ptr<Mapper> m_mapper;
-  std::vector<uint8_t> m_prg_memory;
-  std::vector<uint8_t> m_chr_memory;
-
-  uint8_t m_mapper_id{};
-  uint8_t m_prg_banks{};
-  uint8_t m_chr_banks{};
-
-  bool m_is_valid_image = false;
-};
+#ifndef __CARTRIDGE_H__
+#define __CARTRIDGE_H__
+
+#include "BatteryRam.hpp"
+#include "Mappers.hpp"
+#include "RomCache.hpp"
+#include "SaveState.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Cartridge {
+public:
+  using Mirror = ::Mirror;
+
+  // what the 16-byte tile at a pattern address holds: the memory it is
+  // banked in from and how often that was written. A decode cached under an
+  // equal version is still good without looking at the bytes again; tiles
+  // of CHR-ROM stay at generation 0
+  struct TileVersion {
+    const uint8_t *data = nullptr;
+    uint32_t generation = 0;
+
+    auto operator==(const TileVersion &other) const -> bool {
+      return data == other.data && generation == other.generation;
+    }
+    auto operator!=(const TileVersion &other) const -> bool {
+      return !(*this == other);
+    }
+  };
+
+public:
+  // battery RAM is kept in save_fname when given, on boards with a battery;
+  // otherwise it starts cleared, like any other RAM
+  Cartridge(const std::string &fname, const std::string &save_fname = {});
+  explicit Cartridge(std::shared_ptr<const RomImage> rom,
+                     const std::string &save_fname = {});
+  // ROM files that are no file: plain, gzipped or zipped, the way
+  // RomImage::from_bytes and from_stream read them
+  Cartridge(const uint8_t *data, size_t size);
+  explicit Cartridge(std::istream &stream);
+  ~Cartridge() = default;
+
+  // the mapper points into the cartridge's own RAM
+  Cartridge(const Cartridge &) = delete;
+  auto operator=(const Cartridge &) -> Cartridge & = delete;
+
+  // another cartridge of the same game at power-on, never sharing the save
+  // file with this one
+  auto clone() const -> std::shared_ptr<Cartridge>;
+
+  auto read_cpu(uint16_t address, uint8_t &data) -> bool;
+  auto write_cpu(uint16_t address, uint8_t data) -> bool;
+
+  auto read_ppu(uint16_t address, uint8_t &data) -> bool;
+  auto write_ppu(uint16_t address, uint8_t data) -> bool;
+
+  auto get_tile_version(uint16_t address) const -> TileVersion;
+
+  // start of the 256-byte CPU page at address, or nullptr when the page is
+  // not backed by cartridge memory
+  auto map_cpu_page(uint16_t address) -> const uint8_t *;
+
+  // wires the console's two nametables into the cartridge, which decides
+  // what $2000-$2fff reaches; a cartridge is in one console at a time
+  auto connect_ciram(uint8_t *table_0, uint8_t *table_1) -> void;
+  // the 1kB page behind each nametable, repointed as the mapper switches
+  // mirroring; the array itself stays put
+  auto get_name_tables() const -> const std::array<uint8_t *, 4> &;
+
+  auto is_valid_image() -> bool;
+  // the board has a battery and its RAM is kept in the save file
+  auto is_battery_saved() const -> bool;
+  // around frames that are thrown away: writes to battery RAM made while
+  // detached never reach the save file and are dropped on attaching; true
+  // on boards without one
+  auto detach_battery() -> bool;
+  auto attach_battery() -> bool;
+  // as the mapper currently has it
+  auto mirror() const -> Mirror;
+  auto is_irq_asserted() const -> bool;
+  auto is_watching_a12() const -> bool;
+  auto notify_a12_rise() -> void;
+  // what the header says about the board; defaults for invalid images
+  auto get_descriptor() const -> const RomDescriptor &;
+
+  // writable state only: mapper registers and cartridge RAM
+  auto save_state(CartridgeState &state) const -> void;
+  auto load_state(const CartridgeState &state) -> bool;
+
+  // back to how the board powers on: mapper registers as created and RAM
+  // cleared, except for battery RAM
+  auto power_on() -> void;
+
+private:
+  auto create_mapper() -> void;
+
+private:
+  std::shared_ptr<Mapper> m_mapper;
+  MapperState m_power_on_mapper{};
+  // ROM is shared with every other cartridge of the same file, a cartridge
+  // only owns its writable state
+  std::shared_ptr<const RomImage> m_rom;
+  // PRG-RAM lives in the save file on boards keeping it there, in
+  // m_prg_ram_storage otherwise
+  uint8_t *m_prg_ram = nullptr;
+  size_t m_prg_ram_size = 0;
+  std::vector<uint8_t> m_prg_ram_storage;
+  std::unique_ptr<BatteryRam> m_battery_ram;
+  std::vector<uint8_t> m_chr_ram;
+  // bumped on every write into the 16 bytes of CHR-RAM each one covers
+  std::vector<uint32_t> m_tile_generations;
+  std::vector<uint8_t> m_vram; // four-screen boards only
+
+  uint16_t m_mapper_id{};
+  uint8_t m_prg_banks{};
+  uint8_t m_chr_banks{};
+  bool m_has_chr_ram = false;
+
+  bool m_is_valid_image = false;
+};
 #endif // __CARTRIDGE_H__
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef __CHECKSUM_H__
+#define __CHECKSUM_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The checksums ROM databases identify dumps by
+ *
+ * CRC32 is the zlib/PNG one. It folds 64 bytes at a time with carry-less
+ * multiplies on CPUs that have them and falls back to slicing by 8 tables
+ * everywhere else; both give the same result.
+ */
+class Checksum final {
+public:
+  using Sha1Digest = std::array<uint8_t, 20>;
+
+  // continues from a previous result, so data may come in pieces
+  static auto crc32(const uint8_t *data, size_t size, uint32_t crc = 0)
+      -> uint32_t;
+
+  static auto sha1(const uint8_t *data, size_t size) -> Sha1Digest;
+};
+
+#endif // __CHECKSUM_H__
@@ -0,0 +1,64 @@
+#ifndef __FRAME_PACER_H__
+#define __FRAME_PACER_H__
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Paces emulated frames to the console refresh rate
+ *
+ * Deadlines are derived from the frame count since the last resync, so
+ * rounding never accumulates into drift. Waiting sleeps until shortly
+ * before a deadline and spins for the remainder.
+ */
+class FramePacer final {
+public:
+  using clock = std::chrono::steady_clock;
+
+  enum class Rate : uint8_t {
+    NTSC,    // 60.0988 Hz
+    PAL,     // 50.0070 Hz
+    Uncapped // no waiting at all
+  };
+
+  // lateness of each wake-up relative to its deadline, in milliseconds
+  struct Statistics {
+    uint64_t frames = 0;
+    double mean_late_ms = 0.0;
+    double jitter_ms = 0.0; // standard deviation of the lateness
+    double max_late_ms = 0.0;
+    uint64_t resyncs = 0;
+  };
+
+public:
+  explicit FramePacer(Rate rate = Rate::NTSC);
+
+  auto set_rate(Rate rate) -> void;
+  auto get_rate() const -> Rate;
+  auto get_frame_period() const -> clock::duration;
+
+  // refresh rate of the emulated console in Hz; NTSC when uncapped
+  static auto get_frequency(Rate rate) -> double;
+
+  // blocks until the deadline of the next frame
+  auto wait() -> void;
+  // restarts the schedule from now, e.g. after pausing
+  auto resync() -> void;
+
+  auto get_statistics() const -> Statistics;
+  auto reset_statistics() -> void;
+
+private:
+  auto deadline(uint64_t frame) const -> clock::time_point;
+  auto record(clock::duration lateness) -> void;
+
+private:
+  Rate m_rate;
+  clock::time_point m_start;
+  uint64_t m_frame = 0;
+
+  Statistics m_statistics;
+  double m_late_m2 = 0.0; // running sum of squared deviations
+};
+
+#endif // __FRAME_PACER_H__
@@ -0,0 +1,82 @@
+#ifndef __INFLATE_H__
+#define __INFLATE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief DEFLATE decoder for ROMs kept in gzip files and zip archives
+ *
+ * Reads either a span of bytes in place or a source it pulls chunks from,
+ * so archives are decoded as they are read without a copy of the
+ * compressed data. The container formats around the compressed data are
+ * read through the same object, one byte-aligned field at a time.
+ */
+class Inflate final {
+public:
+  // reads up to size bytes into buffer and returns how many, 0 at the end
+  using Source = std::function<size_t(uint8_t *buffer, size_t size)>;
+
+  // no NES ROM comes close; anything larger is a broken or hostile file
+  static constexpr size_t MaxOutput = size_t(64) << 20;
+
+public:
+  Inflate(const uint8_t *data, size_t size);
+  explicit Inflate(Source source);
+
+  Inflate(const Inflate &) = delete;
+  auto operator=(const Inflate &) -> Inflate & = delete;
+
+  // decodes one DEFLATE stream, appending it to out; false when the data is
+  // corrupt, truncated or would grow out past MaxOutput. A container that
+  // knows the decoded size passes it, so out is allocated once
+  auto inflate(std::vector<uint8_t> &out, size_t expected_size = 0) -> bool;
+
+  // byte-aligned reads of the fields around the compressed data; false when
+  // the input ends first
+  auto read_bytes(uint8_t *data, size_t size) -> bool;
+  auto skip_bytes(size_t size) -> bool;
+  // copies whatever input is left to the end of out
+  auto read_rest(std::vector<uint8_t> &out) -> bool;
+
+private:
+  // a decoding table: 2^primary_bits entries indexed by the next input
+  // bits, followed by the subtables of codes longer than that
+  struct Table {
+    std::vector<uint32_t> entries;
+    uint8_t primary_bits = 0;
+  };
+
+  static auto build_table(const uint8_t *lengths, size_t count,
+                          uint8_t primary_bits, Table &table) -> bool;
+  static auto get_fixed_tables() -> const std::pair<Table, Table> &;
+
+  auto read_chunk() -> bool;
+  auto fill_bits() -> void;
+  auto get_bits(uint8_t count) -> uint32_t;
+  auto decode(const Table &table) -> uint32_t;
+
+  auto read_dynamic_tables() -> bool;
+  auto inflate_stored(std::vector<uint8_t> &out, size_t &size) -> bool;
+  auto inflate_block(const Table &litlen, const Table &dist,
+                     std::vector<uint8_t> &out, size_t &size) -> bool;
+
+private:
+  const uint8_t *m_next = nullptr;
+  const uint8_t *m_end = nullptr;
+  Source m_source;
+  std::vector<uint8_t> m_chunk;
+
+  // input bits not consumed yet, the next one lowest; the count goes
+  // negative once more bits were taken than the input had
+  uint64_t m_bits = 0;
+  int m_bit_count = 0;
+
+  Table m_litlen;
+  Table m_dist;
+};
+
+#endif // __INFLATE_H__
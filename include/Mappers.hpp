@@ -1,42 +1,254 @@
-#ifndef __MAPPERS_H__
-#define __MAPPERS_H__
-
-#include <cstdint>
-
-// the purpose of a mapper is to translate the address
-
-class Mapper {
-public:
-  // Mapper() = delete;
-  Mapper(const Mapper &) = delete;
-  Mapper(Mapper &&) = delete;
-
-  Mapper(uint8_t prg_banks, uint8_t char_bank);
-  virtual ~Mapper() = default;
-
-  auto operator=(const Mapper &) -> Mapper & = delete;
-  auto operator=(Mapper &&) -> Mapper & = delete;
-
-  virtual auto read_cpu(uint16_t address, uint32_t &mapped_addr) -> bool = 0;
-  virtual auto write_cpu(uint16_t address, uint32_t &mapped_addr) -> bool = 0;
-
-  virtual auto read_ppu(uint16_t address, uint32_t &mapped_addr) -> bool = 0;
-  virtual auto write_ppu(uint16_t address, uint32_t &mapped_addr) -> bool = 0;
-
-protected:
-  uint8_t m_prg_banks{};
-  uint8_t m_char_banks{};
-};
-
-class Mapper_000 : public Mapper {
-
-public:
-  Mapper_000(uint8_t prg_banks, uint8_t char_bank);
-
-  auto read_cpu(uint16_t address, uint32_t &mapped_addr) -> bool override;
-  auto write_cpu(uint16_t address, uint32_t &mapped_addr) -> bool override;
-  auto read_ppu(uint16_t address, uint32_t &mapped_addr) -> bool override;
-  auto write_ppu(uint16_t address, uint32_t &mapped_addr) -> bool override;
-};
-
+#ifndef __MAPPERS_H__
+#define __MAPPERS_H__
+
+#include "SaveState.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+// FourScreen boards carry the RAM for the two nametables the console lacks
+enum class Mirror : uint8_t {
+  Horizontal,
+  Vertical,
+  OneScreenLo,
+  OneScreenHi,
+  FourScreen
+};
+
+// the memory on a board, for its mapper to bank in
+struct CartridgeMemory {
+  const uint8_t *prg_rom = nullptr;
+  size_t prg_rom_size = 0;
+  uint8_t *prg_ram = nullptr; // at $6000, on boards that have any
+  size_t prg_ram_size = 0;
+  const uint8_t *chr_rom = nullptr;
+  size_t chr_rom_size = 0;
+  uint8_t *chr_ram = nullptr; // instead of CHR-ROM
+  size_t chr_ram_size = 0;
+  uint8_t *vram = nullptr; // 2kB behind $2800-$2fff, four-screen boards only
+  Mirror mirror = Mirror::Horizontal; // as soldered, for fixed mirroring
+};
+
+/**
+ * @brief Decides which part of the board's memory each address reaches
+ *
+ * Rather than translating every access, a mapper points each 8kB slot of
+ * the CPU address space and each 1kB slot of the pattern tables at the
+ * bank it selects, and only repoints them when its registers are written.
+ * A read is then bank[address >> 13][address & 0x1fff] with no call into
+ * the mapper at all. Slots the cartridge leaves alone stay nullptr; writes
+ * that land in no writable slot are register writes. The four nametables
+ * of $2000-$2fff are pointed at 1kB pages the same way, so mirroring is
+ * whatever the pointers say.
+ */
+class Mapper {
+public:
+  Mapper(const Mapper &) = delete;
+  Mapper(Mapper &&) = delete;
+
+  explicit Mapper(const CartridgeMemory &memory);
+  virtual ~Mapper() = default;
+
+  auto operator=(const Mapper &) -> Mapper & = delete;
+  auto operator=(Mapper &&) -> Mapper & = delete;
+
+  auto get_cpu_bank(uint16_t address) const -> const uint8_t * {
+    return m_cpu_read[address >> 13];
+  }
+  auto get_cpu_write_bank(uint16_t address) const -> uint8_t * {
+    return m_cpu_write[address >> 13];
+  }
+  auto get_ppu_bank(uint16_t address) const -> const uint8_t * {
+    return m_ppu_read[(address >> 10) & 0x07];
+  }
+  auto get_ppu_write_bank(uint16_t address) const -> uint8_t * {
+    return m_ppu_write[(address >> 10) & 0x07];
+  }
+
+  // the page behind each 1kB nametable; the console's two are only known
+  // once the cartridge is inserted, until then they are nullptr
+  auto get_name_tables() const -> const std::array<uint8_t *, 4> & {
+    return m_name_tables;
+  }
+  auto connect_ciram(uint8_t *table_0, uint8_t *table_1) -> void;
+
+  auto get_mirror() const -> Mirror { return m_mirror; }
+  // the level of the cartridge's IRQ line, held until the game acknowledges
+  auto is_irq_asserted() const -> bool { return m_is_irq; }
+
+  // a CPU write to the cartridge outside its writable memory; false when
+  // the board does not decode the address
+  virtual auto write_register(uint16_t address, uint8_t data) -> bool = 0;
+  // boards counting rises of PPU A12 say so, the PPU only tracks it for them
+  virtual auto is_watching_a12() const -> bool { return false; }
+  virtual auto notify_a12_rise() -> void {}
+
+  // mappers with registers lay them out in MapperState::registers, and
+  // repoint their banks once they are loaded
+  virtual auto save_state(MapperState &state) const -> void;
+  virtual auto load_state(const MapperState &state) -> void;
+
+protected:
+  // banks count from the start of their memory in units of their own size
+  // and wrap around it; PRG slots count from $8000
+  auto map_prg_8k(size_t slot, size_t bank) -> void;
+  auto map_prg_16k(size_t slot, size_t bank) -> void;
+  auto map_prg_32k(size_t bank) -> void;
+  auto map_prg_ram(size_t bank) -> void;
+  auto map_chr_1k(size_t slot, size_t bank) -> void;
+  auto map_chr_4k(size_t slot, size_t bank) -> void;
+  auto map_chr_8k(size_t bank) -> void;
+  // repoints the nametables; four-screen boards keep their own wiring
+  auto set_mirror(Mirror mirror) -> void;
+
+  // in 8kB banks for PRG, 1kB banks for CHR
+  auto get_prg_bank_count() const -> size_t;
+  auto get_chr_bank_count() const -> size_t;
+
+protected:
+  const CartridgeMemory m_memory;
+  bool m_is_irq = false;
+
+private:
+  Mirror m_mirror;
+  // console RAM in the first two, cartridge VRAM in the last two
+  std::array<uint8_t *, 4> m_pages{};
+  std::array<uint8_t *, 4> m_name_tables{};
+  std::array<const uint8_t *, 8> m_cpu_read{};
+  std::array<uint8_t *, 8> m_cpu_write{};
+  std::array<const uint8_t *, 8> m_ppu_read{};
+  std::array<uint8_t *, 8> m_ppu_write{};
+};
+
+/**
+ * @brief Creates mappers by their iNES number
+ *
+ * Every mapper registers itself next to its definition, so adding one
+ * takes nothing outside of its own code. Numbers without a mapper are
+ * refused when the cartridge is loaded.
+ */
+class MapperFactory final {
+public:
+  using Create = auto (*)(const CartridgeMemory &memory)
+      -> std::shared_ptr<Mapper>;
+
+  template <typename T> struct Registration {
+    explicit Registration(uint16_t mapper_id) {
+      add(mapper_id,
+          [](const CartridgeMemory &memory) -> std::shared_ptr<Mapper> {
+            return std::make_shared<T>(memory);
+          });
+    }
+  };
+
+  static auto add(uint16_t mapper_id, Create create) -> void;
+  // nullptr for numbers without a mapper
+  static auto create(uint16_t mapper_id, const CartridgeMemory &memory)
+      -> std::shared_ptr<Mapper>;
+  static auto is_supported(uint16_t mapper_id) -> bool;
+
+private:
+  // built during static initialisation, in whatever order that runs
+  static auto get_registry() -> std::unordered_map<uint16_t, Create> &;
+};
+
+// NROM: no registers
+class Mapper_000 : public Mapper {
+
+public:
+  explicit Mapper_000(const CartridgeMemory &memory);
+
+  auto write_register(uint16_t address, uint8_t data) -> bool override;
+};
+
+// MMC1: five serial writes fill one of four registers
+class Mapper_001 : public Mapper {
+public:
+  explicit Mapper_001(const CartridgeMemory &memory);
+
+  auto write_register(uint16_t address, uint8_t data) -> bool override;
+  auto save_state(MapperState &state) const -> void override;
+  auto load_state(const MapperState &state) -> void override;
+
+private:
+  auto update_banks() -> void;
+
+  uint8_t m_shift = 0x10; // the one marks when the fifth write comes
+  uint8_t m_control = 0x0c;
+  uint8_t m_chr_0 = 0x00;
+  uint8_t m_chr_1 = 0x00;
+  uint8_t m_prg = 0x00;
+};
+
+// UxROM: 16kB switched at $8000, the last bank fixed at $c000
+class Mapper_002 : public Mapper {
+public:
+  explicit Mapper_002(const CartridgeMemory &memory);
+
+  auto write_register(uint16_t address, uint8_t data) -> bool override;
+  auto save_state(MapperState &state) const -> void override;
+  auto load_state(const MapperState &state) -> void override;
+
+private:
+  auto update_banks() -> void;
+
+  uint8_t m_prg = 0x00;
+};
+
+// CNROM: 8kB of CHR switched
+class Mapper_003 : public Mapper {
+public:
+  explicit Mapper_003(const CartridgeMemory &memory);
+
+  auto write_register(uint16_t address, uint8_t data) -> bool override;
+  auto save_state(MapperState &state) const -> void override;
+  auto load_state(const MapperState &state) -> void override;
+
+private:
+  auto update_banks() -> void;
+
+  uint8_t m_chr = 0x00;
+};
+
+// MMC3: 8kB PRG and 1kB/2kB CHR banks, and an IRQ counting A12 rises
+class Mapper_004 : public Mapper {
+public:
+  explicit Mapper_004(const CartridgeMemory &memory);
+
+  auto write_register(uint16_t address, uint8_t data) -> bool override;
+  auto is_watching_a12() const -> bool override;
+  auto notify_a12_rise() -> void override;
+  auto save_state(MapperState &state) const -> void override;
+  auto load_state(const MapperState &state) -> void override;
+
+private:
+  auto update_banks() -> void;
+
+  std::array<uint8_t, 8> m_banks{0, 2, 4, 5, 6, 7, 0, 1};
+  uint8_t m_select = 0x00;
+  uint8_t m_mirroring = 0x00;
+  uint8_t m_irq_latch = 0x00;
+  uint8_t m_irq_counter = 0x00;
+  bool m_is_irq_reload = false;
+  bool m_is_irq_enabled = false;
+};
+
+// AxROM: 32kB of PRG switched, one-screen mirroring
+class Mapper_007 : public Mapper {
+public:
+  explicit Mapper_007(const CartridgeMemory &memory);
+
+  auto write_register(uint16_t address, uint8_t data) -> bool override;
+  auto save_state(MapperState &state) const -> void override;
+  auto load_state(const MapperState &state) -> void override;
+
+private:
+  auto update_banks() -> void;
+
+  uint8_t m_bank = 0x00;
+};
+
 #endif // __MAPPERS_H__
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef __MOVIE_H__
+#define __MOVIE_H__
+
+#include "Bus.hpp"
+#include "SaveState.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Recorded controller input, replayable frame for frame
+ *
+ * A movie starts either at power-on or from a save state and stores the
+ * buttons of both ports for every frame, two bytes per frame. Replaying it
+ * on the same ROM reproduces the session exactly, as the emulation itself
+ * is deterministic.
+ */
+class Movie final {
+public:
+  static constexpr uint32_t Magic = 0x564f4d4e; // "NMOV" in file order
+  static constexpr uint32_t Version = 1;
+
+  // bitmasks of both controller ports, laid out as Bus::m_controller
+  using Input = std::array<uint8_t, 2>;
+
+public:
+  // discards the recorded input and starts over
+  auto start_from_power_on() -> void;
+  auto start_from_state(const SaveState &state) -> void;
+
+  auto record(const Input &input) -> void;
+
+  auto get_frame_count() const -> size_t;
+  auto get_input(size_t frame) const -> const Input &;
+  auto has_start_state() const -> bool;
+
+  // powers nes on, or loads the start state, to where the movie starts;
+  // fails for start states of another game
+  auto restore_start(Bus &nes) const -> bool;
+
+  auto write_file(const std::string &fname) const -> bool;
+  static auto read_file(const std::string &fname, Movie &movie) -> bool;
+
+private:
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t frames;
+  };
+  static constexpr uint32_t HasStartState = 1 << 0;
+
+  std::unique_ptr<SaveState> m_start_state;
+  std::vector<Input> m_inputs;
+};
+
+#endif // __MOVIE_H__
@@ -0,0 +1,127 @@
+#ifndef __NETPLAY_H__
+#define __NETPLAY_H__
+
+#include "Bus.hpp"
+#include "SaveState.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Carries netplay packets between two peers
+ *
+ * Packets may be lost, duplicated or reordered; sessions resend whatever
+ * the other side has not acknowledged yet.
+ */
+class Transport {
+public:
+  virtual ~Transport() = default;
+
+  virtual auto send(const std::vector<uint8_t> &packet) -> void = 0;
+  // never blocks; false when nothing has arrived
+  virtual auto receive(std::vector<uint8_t> &packet) -> bool = 0;
+};
+
+/**
+ * @brief In-process transport between two sessions, with injected latency
+ */
+class LoopbackTransport final : public Transport {
+public:
+  using clock = std::chrono::steady_clock;
+
+  // two connected ends, each packet is delivered latency after it was sent
+  static auto create_pair(clock::duration latency)
+      -> std::pair<std::unique_ptr<LoopbackTransport>,
+                   std::unique_ptr<LoopbackTransport>>;
+
+  auto send(const std::vector<uint8_t> &packet) -> void override;
+  auto receive(std::vector<uint8_t> &packet) -> bool override;
+
+private:
+  struct Channel {
+    std::mutex mutex;
+    std::deque<std::pair<clock::time_point, std::vector<uint8_t>>> packets;
+  };
+
+  LoopbackTransport(std::shared_ptr<Channel> outgoing,
+                    std::shared_ptr<Channel> incoming,
+                    clock::duration latency);
+
+private:
+  std::shared_ptr<Channel> m_outgoing;
+  std::shared_ptr<Channel> m_incoming;
+  clock::duration m_latency;
+};
+
+/**
+ * @brief Two-player session that hides network latency by rolling back
+ *
+ * Every frame runs straight away with the last known remote input as the
+ * prediction. Once the real remote input for a frame turns out different,
+ * the console goes back to the snapshot before that frame and re-runs up
+ * to the present without drawing. Sessions stall rather than predict more
+ * than MaxRollback frames ahead of the confirmed remote input.
+ */
+class RollbackSession final {
+public:
+  static constexpr uint32_t MaxRollback = 8;
+
+  struct Statistics {
+    uint64_t rollbacks = 0;
+    uint64_t resimulated_frames = 0;
+    uint32_t max_rollback_frames = 0;
+    double max_rollback_ms = 0.0;
+    uint64_t stalls = 0;
+  };
+
+public:
+  // both peers must start from the same state with their own port each
+  RollbackSession(Bus &nes, std::unique_ptr<Transport> transport,
+                  uint8_t local_port);
+
+  // runs the next frame with the local input, drawing it if is_shown;
+  // false when stalled waiting for the remote peer
+  auto advance(uint8_t local_input, bool is_shown = true) -> bool;
+  // takes in remote input and rolls back if a prediction was wrong
+  auto poll() -> void;
+
+  // frames run so far, and how many of them used only confirmed input
+  auto get_frame() const -> uint32_t;
+  auto get_confirmed_frame() const -> uint32_t;
+
+  auto get_statistics() const -> Statistics;
+
+private:
+  auto predict_remote(uint32_t frame) const -> uint8_t;
+  auto simulate(uint32_t frame, bool is_shown) -> void;
+  auto rollback(uint32_t frame) -> void;
+  auto send_inputs() -> void;
+
+private:
+  Bus &m_nes;
+  std::unique_ptr<Transport> m_transport;
+  uint8_t m_local_port;
+
+  uint32_t m_frame = 0;
+  // local inputs of every frame, and how many of them the peer has
+  std::vector<uint8_t> m_local;
+  uint32_t m_peer_ack = 0;
+  // confirmed remote inputs, and the remote inputs each frame ran with
+  std::vector<uint8_t> m_remote;
+  std::vector<uint8_t> m_used_remote;
+
+  // state going into each of the last frames, indexed by frame
+  std::array<std::unique_ptr<SaveState>, MaxRollback + 1> m_snapshots;
+  std::vector<uint8_t> m_packet;
+
+  Statistics m_statistics;
+};
+
+#endif // __NETPLAY_H__
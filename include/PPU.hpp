@@ -1,101 +1,279 @@
-#ifndef __PPU_H__
-#define __PPU_H__
-
-#include "Cartridge.hpp"
-#include "olcPixelGameEngine.hpp"
-
-#include <array>
-#include <cstdint>
-#include <memory>
-
-class PPU {
-public:
-  PPU() = default; // subject to implementation
-  ~PPU() = default;
-
-  auto read_cpu(uint16_t address, bool is_read_only) -> uint8_t;
-  auto write_cpu(uint16_t address, uint8_t data) -> void;
-
-  auto read_ppu(uint16_t address, bool is_read_only) -> uint8_t;
-  auto write_ppu(uint16_t address, uint8_t data) -> void;
-
-  auto connect(const std::shared_ptr<Cartridge> &cartridge) -> void;
-  auto clock() -> void;
-
-public:
-  // debugging tools
-  auto get_screen() -> olc::Sprite &;
-  auto get_table_name(uint8_t i) -> olc::Sprite &;
-  auto get_table_pattern(uint8_t i) -> olc::Sprite &;
-
-private:
-  std::array<std::array<uint8_t, 4096>, 2> table_pattern{};
-  std::array<std::array<uint8_t, 1024>, 2> table_name{};
-  std::array<uint8_t, 32> table_pallette{};
-
-  const std::array<olc::Pixel, 64> m_pal_screen{
-      olc::Pixel{84, 84, 84},    olc::Pixel{0, 30, 116},
-      olc::Pixel{8, 16, 144},    olc::Pixel{48, 0, 136},
-      olc::Pixel{68, 0, 100},    olc::Pixel{92, 0, 48},
-      olc::Pixel{84, 4, 0},      olc::Pixel{60, 24, 0},
-      olc::Pixel{32, 42, 0},     olc::Pixel{8, 58, 0},
-      olc::Pixel{0, 64, 0},      olc::Pixel{0, 60, 0},
-      olc::Pixel{0, 50, 60},     olc::Pixel{0, 0, 0},
-      olc::Pixel{0, 0, 0},       olc::Pixel{0, 0, 0},
-
-      olc::Pixel{152, 150, 152}, olc::Pixel{8, 76, 196},
-      olc::Pixel{48, 50, 236},   olc::Pixel{92, 30, 228},
-      olc::Pixel{136, 20, 176},  olc::Pixel{160, 20, 100},
-      olc::Pixel{152, 34, 32},   olc::Pixel{120, 60, 0},
-      olc::Pixel{84, 90, 0},     olc::Pixel{40, 114, 0},
-      olc::Pixel{8, 124, 0},     olc::Pixel{0, 118, 40},
-      olc::Pixel{0, 102, 120},   olc::Pixel{0, 0, 0},
-      olc::Pixel{0, 0, 0},       olc::Pixel{0, 0, 0},
-
-      olc::Pixel{236, 238, 236}, olc::Pixel{76, 154, 236},
-      olc::Pixel{120, 124, 236}, olc::Pixel{176, 98, 236},
-      olc::Pixel{228, 84, 236},  olc::Pixel{236, 88, 180},
-      olc::Pixel{236, 106, 100}, olc::Pixel{212, 136, 32},
-      olc::Pixel{160, 170, 0},   olc::Pixel{116, 196, 0},
-      olc::Pixel{76, 208, 32},   olc::Pixel{56, 204, 108},
-      olc::Pixel{56, 180, 204},  olc::Pixel{60, 60, 60},
-      olc::Pixel{0, 0, 0},       olc::Pixel{0, 0, 0},
-
-      olc::Pixel{236, 238, 236}, olc::Pixel{168, 204, 236},
-      olc::Pixel{188, 188, 236}, olc::Pixel{212, 178, 236},
-      olc::Pixel{236, 174, 236}, olc::Pixel{236, 174, 212},
-      olc::Pixel{236, 180, 176}, olc::Pixel{228, 196, 144},
-      olc::Pixel{204, 210, 120}, olc::Pixel{180, 222, 120},
-      olc::Pixel{168, 226, 144}, olc::Pixel{152, 226, 180},
-      olc::Pixel{160, 214, 228}, olc::Pixel{160, 162, 160},
-      olc::Pixel{0, 0, 0},       olc::Pixel{0, 0, 0}};
-
-  std::array<olc::Sprite, 2> m_spr_table_name{olc::Sprite{256, 240},
-                                              olc::Sprite{256, 240}};
-  std::array<olc::Sprite, 2> m_spr_table_pattern{olc::Sprite{128, 128},
-                                                 olc::Sprite{128, 128}};
-
-  olc::Sprite m_screen{256, 240};
-
-private:
-  enum class PPUConstants : int {
-    Control = 0x0000,
-    Mask = 0x0001,
-    PStatus = 0x0002,
-    OAM_Address = 0x0003,
-    OAM_Data = 0x0004,
-    Scroll = 0x0005,
-    PPU_Address = 0x0006,
-    PPU_Data = 0x0007
-  };
-
-  int16_t m_scan_line = 0;
-  int16_t m_cycle = 0;
-
-  std::shared_ptr<Cartridge> m_cartridge;
-
-public:
-  bool m_is_frame_complete = false;
-};
-
+#ifndef __PPU_H__
+#define __PPU_H__
+
+#include "Cartridge.hpp"
+#include "SaveState.hpp"
+#include "olcPixelGameEngine.hpp"
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class PPU {
+public:
+  // layout of the pixels written into the framebuffer. RGBA and BGRA are
+  // byte orders in memory (RGBA matches olc::Pixel); Index writes one byte
+  // per pixel holding the 6-bit palette index, with the emphasis bits of each
+  // scanline available through get_emphasis()
+  enum class PixelFormat : uint8_t { RGBA, BGRA, Index };
+
+  static constexpr int ScreenWidth = 256;
+  static constexpr int ScreenHeight = 240;
+
+  // output colour for every (emphasis << 6) | palette index combination
+  using ColourTable = std::array<uint32_t, 512>;
+
+public:
+  PPU();
+  ~PPU() = default;
+
+  auto read_cpu(uint16_t address, bool is_read_only = false) -> uint8_t;
+  auto write_cpu(uint16_t address, uint8_t data) -> void;
+
+  auto read_ppu(uint16_t address, bool is_read_only = false) -> uint8_t;
+  auto write_ppu(uint16_t address, uint8_t data) -> void;
+
+  auto connect(const std::shared_ptr<Cartridge> &cartridge) -> void;
+  auto clock() -> void;
+
+  // OAM DMA: copies a 256-byte page into OAM starting at OAMADDR
+  auto write_oam(const uint8_t *page) -> void;
+
+  auto save_state(PPUState &state) const -> void;
+  auto load_state(const PPUState &state) -> void;
+  auto reset() -> void;
+  // clears nametables, palette and OAM as well, then resets
+  auto power_on() -> void;
+
+  // the buffer must hold 256 x 240 pixels in the given format and outlive its
+  // use by the PPU; passing nullptr restores the internal buffer
+  auto set_framebuffer(uint32_t *buffer, PixelFormat format) -> void;
+  auto get_framebuffer() -> uint32_t *;
+  auto get_pixel_format() const -> PixelFormat;
+  static auto get_bytes_per_pixel(PixelFormat format) -> size_t;
+  auto get_emphasis(int scan_line) const -> uint8_t;
+
+  // with pixel output disabled the PPU keeps timing, status flags and
+  // sprite-0 hits exact but writes nothing to the framebuffer; used to skip
+  // frames nobody will look at
+  auto set_pixel_output(bool is_enabled) -> void;
+  auto get_pixel_output() const -> bool;
+
+  // replaces the colour tables of every PPU with a .pal file, holding either
+  // 64 RGB triples (emphasis is derived) or 512 (emphasis included); meant to
+  // be called at startup, before any PPU renders
+  static auto load_palette(const std::string &fname) -> bool;
+
+public:
+  // debugging tools; each view only redraws the tiles that changed since it
+  // was last requested, pattern tiles going by the cartridge's tile versions
+  // so bank switches count as well
+  auto get_table_name(uint8_t i) -> olc::Sprite &;
+  auto get_table_pattern(uint8_t i, uint8_t palette = 0) -> olc::Sprite &;
+
+  // forces a full redraw
+  auto invalidate_debug_views() -> void;
+
+private:
+  auto flush_line() -> void;
+
+  // a nametable byte of $2000-$2fff, or its mirror at $3000
+  auto read_name(uint16_t address) const -> uint8_t;
+
+  // sets the tiles of one pattern table whose version differs from the one
+  // in versions, and updates it
+  auto collect_changed_tiles(
+      uint16_t table, std::array<Cartridge::TileVersion, 256> &versions,
+      std::bitset<256> &changed) -> void;
+  auto mark_name_dirty(uint8_t table, uint16_t offset) -> void;
+  // marks the views drawn through a palette entry, address being $3f00-based
+  auto mark_palette_dirty(uint8_t address) -> void;
+  auto get_name_palette(uint8_t i, uint16_t entry) const -> uint8_t;
+  auto draw_pattern_tile(uint8_t i, uint8_t tile, uint8_t palette) -> void;
+  auto draw_name_entry(uint8_t i, uint16_t entry) -> void;
+
+  auto increment_scroll_x() -> void;
+  auto increment_scroll_y() -> void;
+  auto transfer_address_x() -> void;
+  auto transfer_address_y() -> void;
+  auto load_background_shifters() -> void;
+  auto update_shifters() -> void;
+
+  auto evaluate_sprites() -> void;
+  auto render_sprite_line() -> void;
+
+  auto update_a12_watch() -> void;
+  auto follow_a12_fetch() -> void;
+  auto track_a12(bool is_high) -> void;
+  auto notify_a12_rise() -> void;
+  auto get_dot_position() const -> int32_t;
+
+private:
+  std::array<std::array<uint8_t, 4096>, 2> table_pattern{};
+  std::array<std::array<uint8_t, 1024>, 2> table_name{};
+  std::array<uint8_t, 32> table_pallette{};
+
+  // 2C02 output colours packed as olc::Pixel (R in the lowest byte) and with
+  // R and B swapped, shared by every PPU instance
+  static ColourTable s_colours_rgba;
+  static ColourTable s_colours_bgra;
+
+  std::array<olc::Sprite, 2> m_spr_table_name{olc::Sprite{256, 240},
+                                              olc::Sprite{256, 240}};
+  std::array<olc::Sprite, 2> m_spr_table_pattern{olc::Sprite{128, 128},
+                                                 olc::Sprite{128, 128}};
+
+  // stale tiles of each debug view, and the versions of the pattern tiles
+  // each one was last drawn from (the background table for nametables)
+  std::array<std::bitset<256>, 2> m_pattern_dirty{};
+  std::array<std::bitset<960>, 2> m_name_dirty{};
+  std::array<std::array<Cartridge::TileVersion, 256>, 2> m_pattern_versions{};
+  std::array<std::array<Cartridge::TileVersion, 256>, 2> m_name_versions{};
+  std::array<uint8_t, 2> m_pattern_view_palette{};
+
+  // framebuffer used until the caller supplies one
+  alignas(64) std::array<uint32_t, ScreenWidth * ScreenHeight> m_frame{};
+  uint32_t *m_framebuffer = m_frame.data();
+  PixelFormat m_pixel_format = PixelFormat::RGBA;
+  bool m_is_pixel_output = true;
+  const uint32_t *m_colours = s_colours_rgba.data();
+  std::array<uint8_t, ScreenHeight> m_emphasis{};
+
+  // colour table indices of the scanline being drawn, converted to the
+  // output format in one pass once the line is complete
+  alignas(64) std::array<uint16_t, ScreenWidth> m_line{};
+
+private:
+  enum class PPUConstants : int {
+    Control = 0x0000,
+    Mask = 0x0001,
+    PStatus = 0x0002,
+    OAM_Address = 0x0003,
+    OAM_Data = 0x0004,
+    Scroll = 0x0005,
+    PPU_Address = 0x0006,
+    PPU_Data = 0x0007
+  };
+
+  // bits of $2000
+  struct ControlFlags {
+    static constexpr uint8_t NametableX = 0x01;
+    static constexpr uint8_t NametableY = 0x02;
+    static constexpr uint8_t IncrementMode = 0x04;
+    static constexpr uint8_t PatternSprite = 0x08;
+    static constexpr uint8_t PatternBackground = 0x10;
+    static constexpr uint8_t SpriteSize = 0x20;
+    static constexpr uint8_t SlaveMode = 0x40;
+    static constexpr uint8_t EnableNmi = 0x80;
+  };
+
+  // bits of $2001
+  struct MaskFlags {
+    static constexpr uint8_t Grayscale = 0x01;
+    static constexpr uint8_t RenderBackgroundLeft = 0x02;
+    static constexpr uint8_t RenderSpritesLeft = 0x04;
+    static constexpr uint8_t RenderBackground = 0x08;
+    static constexpr uint8_t RenderSprites = 0x10;
+    static constexpr uint8_t EmphasisShift = 5;
+  };
+
+  // bits of $2002
+  struct StatusFlags {
+    static constexpr uint8_t SpriteOverflow = 0x20;
+    static constexpr uint8_t SpriteZeroHit = 0x40;
+    static constexpr uint8_t VerticalBlank = 0x80;
+  };
+
+  uint8_t m_control = 0x00;
+  uint8_t m_mask = 0x00;
+  uint8_t m_status = 0x00;
+
+  // loopy registers: yyy NN YYYYY XXXXX
+  // (fine y, nametable select, coarse y, coarse x)
+  uint16_t m_vram_addr = 0x0000;
+  uint16_t m_tram_addr = 0x0000;
+  uint8_t m_fine_x = 0x00;
+
+  uint8_t m_address_latch = 0x00;
+  bool m_odd_frame = false;
+  uint8_t m_ppu_data_buffer = 0x00;
+
+  // background fetches for the next tile and the 16-bit shifters that feed
+  // the pixel multiplexer
+  uint8_t m_bg_next_tile_id = 0x00;
+  uint8_t m_bg_next_tile_attrib = 0x00;
+  uint8_t m_bg_next_tile_lsb = 0x00;
+  uint8_t m_bg_next_tile_msb = 0x00;
+  uint16_t m_bg_shifter_pattern_lo = 0x0000;
+  uint16_t m_bg_shifter_pattern_hi = 0x0000;
+  uint16_t m_bg_shifter_attrib_lo = 0x0000;
+  uint16_t m_bg_shifter_attrib_hi = 0x0000;
+
+  // object attribute memory: y, tile id, attributes, x for 64 sprites
+  struct ObjectAttribute {
+    uint8_t y;
+    uint8_t id;
+    uint8_t attribute;
+    uint8_t x;
+  };
+
+  // bits of ObjectAttribute::attribute
+  struct SpriteFlags {
+    static constexpr uint8_t Palette = 0x03;
+    static constexpr uint8_t Unimplemented = 0x1c;
+    static constexpr uint8_t BehindBackground = 0x20;
+    static constexpr uint8_t FlipHorizontal = 0x40;
+    static constexpr uint8_t FlipVertical = 0x80;
+  };
+
+  // bits of a sprite line buffer entry
+  struct LineFlags {
+    static constexpr uint8_t Pixel = 0x03;
+    static constexpr uint8_t Palette = 0x0c;
+    static constexpr uint8_t BehindBackground = 0x10;
+    static constexpr uint8_t SpriteZero = 0x20;
+  };
+
+  std::array<uint8_t, 256> m_oam{};
+  uint8_t m_oam_addr = 0x00;
+
+  // up to 8 sprites selected for the next scanline, and that scanline
+  // pre-rendered: the first opaque sprite pixel at each x, plus a bitmask of
+  // the x positions holding one so the pixel loop can skip the rest
+  std::array<ObjectAttribute, 8> m_sprite_scan_line{};
+  uint8_t m_sprite_count = 0;
+  bool m_sprite_zero_selected = false;
+  std::array<uint8_t, 256> m_sprite_line{};
+  std::array<uint64_t, 4> m_sprite_mask{};
+
+  int16_t m_scan_line = 0;
+  int16_t m_cycle = 0;
+
+  // A12 of the pattern fetches, for boards counting its rises (MMC3). With
+  // 8x8 sprites on one table and the background on the other it rises once
+  // a line, on a dot that follows from the tables alone; any other setup
+  // follows every fetch. Rises after short lows are filtered out, like the
+  // MMC3 does. None of this is saved, it is rebuilt from the registers
+  bool m_is_watching_a12 = false;
+  int16_t m_a12_rise_dot = -1;
+  bool m_is_a12_per_fetch = false;
+  bool m_a12 = false;
+  int32_t m_a12_fall_at = 0;
+  uint8_t m_sprite_a12 = 0x00; // one bit per sprite slot of the next line
+
+  std::shared_ptr<Cartridge> m_cartridge;
+  // the cartridge's page for each nametable, which it repoints whenever the
+  // mirroring changes; table_name is the console RAM they mostly point into
+  const std::array<uint8_t *, 4> *m_name_tables = nullptr;
+
+public:
+  bool m_is_frame_complete = false;
+  bool m_nmi = false;
+  // the cartridge raised its IRQ line on the last dot
+  bool m_irq = false;
+};
+
 #endif // __PPU_H__
\ No newline at end of file
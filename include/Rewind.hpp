@@ -0,0 +1,86 @@
+#ifndef __REWIND_H__
+#define __REWIND_H__
+
+#include "SaveState.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Ring of per-frame snapshots for rewinding
+ *
+ * Snapshots are grouped behind a periodic keyframe; every other frame is
+ * stored as its XOR against that keyframe, which is mostly zeros, and all of
+ * them are packed with a zero-run encoding. The packing happens on a worker
+ * thread, the emulation thread only hands over a copy of the state and waits
+ * if the worker falls too far behind. Whole groups are dropped, oldest first,
+ * to stay within the memory budget.
+ */
+class RewindBuffer final {
+public:
+  explicit RewindBuffer(size_t budget = size_t(64) << 20,
+                        uint32_t keyframe_interval = 60);
+  ~RewindBuffer();
+
+  RewindBuffer(const RewindBuffer &) = delete;
+  auto operator=(const RewindBuffer &) -> RewindBuffer & = delete;
+
+  // records the state of a new frame
+  auto push(const SaveState &state) -> void;
+  // removes the most recent frame into state; false once empty
+  auto pop(SaveState &state) -> bool;
+  auto clear() -> void;
+
+  auto get_frame_count() const -> size_t;
+  auto get_memory_used() const -> size_t;
+
+private:
+  struct Group {
+    std::vector<uint8_t> keyframe;
+    std::vector<std::vector<uint8_t>> deltas;
+    size_t bytes = 0;
+  };
+
+  auto work() -> void;
+  auto store(const SaveState &state) -> void;
+
+  static auto pack(const uint8_t *src, size_t size, std::vector<uint8_t> &out)
+      -> void;
+  static auto unpack(const std::vector<uint8_t> &src, uint8_t *dst,
+                     size_t size) -> void;
+
+private:
+  const size_t m_budget;
+  const uint32_t m_keyframe_interval;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_idle;
+  std::condition_variable m_room;
+  bool m_quit = false;
+  bool m_is_busy = false;
+
+  // copies waiting for the worker, and spares to avoid reallocating them
+  std::deque<std::unique_ptr<SaveState>> m_pending;
+  std::vector<std::unique_ptr<SaveState>> m_spare;
+
+  std::deque<Group> m_groups;
+  size_t m_frames = 0;
+  size_t m_memory_used = 0;
+
+  // owned by the worker: the keyframe deltas are taken against
+  std::unique_ptr<SaveState> m_keyframe;
+  std::unique_ptr<SaveState> m_scratch;
+  std::vector<uint8_t> m_packed;
+  bool m_has_keyframe = false;
+
+  std::thread m_worker;
+};
+
+#endif // __REWIND_H__
@@ -0,0 +1,83 @@
+#ifndef __ROM_CACHE_H__
+#define __ROM_CACHE_H__
+
+#include "RomHeader.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Read-only contents of one ROM file
+ *
+ * PRG and CHR point straight into the file contents, wherever those live;
+ * storage keeps them alive for as long as the image is.
+ */
+struct RomImage {
+  RomDescriptor descriptor;
+  const uint8_t *prg_rom = nullptr;
+  const uint8_t *chr_rom = nullptr; // nullptr on boards with CHR-RAM
+  std::shared_ptr<const void> storage;
+
+  // lays an image over the contents of a ROM file; nullptr when the header
+  // is invalid or the data too short for the sizes it gives
+  static auto from_memory(const uint8_t *data, size_t size,
+                          std::shared_ptr<const void> storage)
+      -> std::shared_ptr<RomImage>;
+  // the contents of a ROM file, a gzipped one or a zip archive holding one
+  // (the first entry named .nes or starting with an iNES header); the image
+  // owns a copy, or what was inflated. nullptr when it is no ROM
+  static auto from_bytes(const uint8_t *data, size_t size)
+      -> std::shared_ptr<RomImage>;
+  // the same, inflated as it is read from the stream
+  static auto from_stream(std::istream &stream) -> std::shared_ptr<RomImage>;
+  // maps the file read-only rather than copying it, compressed files are
+  // inflated from the mapping; nullptr when the file cannot be read or is
+  // no ROM
+  static auto from_file(const std::string &fname)
+      -> std::shared_ptr<RomImage>;
+
+  // CRC32 of PRG and CHR together, what ROM databases know a dump by
+  auto get_crc32() const -> uint32_t;
+};
+
+class RomDatabase;
+
+/**
+ * @brief Loads every ROM file once and shares it between cartridges
+ *
+ * The cache only keeps weak references, an image is freed together with
+ * the last cartridge using it and loaded afresh when next asked for.
+ * With a database set, headers are corrected from it as files are loaded.
+ */
+class RomCache final {
+public:
+  // nullptr when the file cannot be read
+  static auto get(const std::string &fname)
+      -> std::shared_ptr<const RomImage>;
+  // ROMs that are no file are not cached, every call loads its own image;
+  // they are corrected all the same
+  static auto load(const uint8_t *data, size_t size)
+      -> std::shared_ptr<const RomImage>;
+  static auto load(std::istream &stream) -> std::shared_ptr<const RomImage>;
+
+  // applies to files loaded from now on, nullptr for none
+  static auto set_database(std::shared_ptr<const RomDatabase> database)
+      -> void;
+
+private:
+  static auto correct(const std::shared_ptr<RomImage> &image)
+      -> std::shared_ptr<const RomImage>;
+
+private:
+  static std::mutex s_mutex;
+  static std::shared_ptr<const RomDatabase> s_database;
+  static std::unordered_map<std::string, std::weak_ptr<const RomImage>>
+      s_images;
+};
+
+#endif // __ROM_CACHE_H__
@@ -0,0 +1,76 @@
+#ifndef __ROM_DATABASE_H__
+#define __ROM_DATABASE_H__
+
+#include "Checksum.hpp"
+#include "RomHeader.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Index of a ROM library, keyed by the checksums of PRG and CHR
+ *
+ * The same dump turns up under headers of varying quality, so the
+ * descriptor of the best header found for a checksum, NES 2.0 over iNES
+ * over archaic iNES, is what every copy of it should have had. Loading a
+ * ROM looks that up by CRC32 in a hash map; the rest only matters to
+ * rescans, which reuse files whose size and modification time have not
+ * changed.
+ */
+class RomDatabase final {
+public:
+  // fields of a file's header that disagree with the best one for its dump
+  enum Fix : uint8_t {
+    Mapper = 1 << 0,
+    Submapper = 1 << 1,
+    Mirroring = 1 << 2,
+    Battery = 1 << 3,
+    RamSizes = 1 << 4,
+    Timing = 1 << 5
+  };
+
+  struct Entry {
+    std::string path;
+    int64_t mtime = 0; // nanoseconds since the epoch
+    uint64_t file_size = 0;
+
+    uint32_t crc32 = 0;
+    Checksum::Sha1Digest sha1{};
+    RomDescriptor descriptor;
+    uint8_t fixes = 0;
+  };
+
+  struct ScanStatistics {
+    size_t files = 0;
+    size_t hashed = 0;
+    size_t reused = 0;
+    size_t rejected = 0; // not a readable iNES or NES 2.0 file
+  };
+
+  auto read_file(const std::string &fname) -> bool;
+  auto write_file(const std::string &fname) const -> bool;
+
+  // brings the index up to date with every ROM file (.nes, .gz, .zip) below
+  // root, dropping files that have gone
+  auto scan(const std::string &root, ThreadPool &pool) -> ScanStatistics;
+
+  auto get_entries() const -> const std::vector<Entry> &;
+  // the entry with the best header for a dump, nullptr if unknown
+  auto find(uint32_t crc32) const -> const Entry *;
+
+  // overwrites what the best header for the dump says better; sizes of
+  // ROM stay as they are. true when anything changed
+  auto correct(uint32_t crc32, RomDescriptor &descriptor) const -> bool;
+
+private:
+  auto index() -> void;
+
+  std::vector<Entry> m_entries; // sorted by path
+  std::unordered_map<uint32_t, size_t> m_best;
+};
+
+#endif // __ROM_DATABASE_H__
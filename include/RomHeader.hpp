@@ -0,0 +1,69 @@
+#ifndef __ROM_HEADER_H__
+#define __ROM_HEADER_H__
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief The 16-byte header in front of iNES and NES 2.0 files, as stored
+ */
+struct RomHeader {
+  static constexpr std::array<uint8_t, 4> Magic{'N', 'E', 'S', 0x1a};
+
+  std::array<uint8_t, 4> magic;
+  uint8_t prg_rom_chunks; // 16kB units, or exponent form in NES 2.0
+  uint8_t chr_rom_chunks; // 8kB units, or exponent form in NES 2.0
+  uint8_t flags_6;        // mirroring, battery, trainer, mapper low nibble
+  uint8_t flags_7;        // console type, format, mapper middle nibble
+  uint8_t flags_8;        // NES 2.0: mapper high nibble and submapper
+  uint8_t flags_9;        // NES 2.0: PRG/CHR-ROM size high nibbles
+  uint8_t flags_10;       // NES 2.0: PRG-RAM and PRG-NVRAM shift counts
+  uint8_t flags_11;       // NES 2.0: CHR-RAM and CHR-NVRAM shift counts
+  uint8_t flags_12;       // NES 2.0: CPU/PPU timing
+  std::array<uint8_t, 3> flags_13_15;
+};
+
+static_assert(sizeof(RomHeader) == 16, "the header is 16 bytes on disk");
+
+/**
+ * @brief Everything the header says about a cartridge, decoded and checked
+ *
+ * All sizes are in bytes. Older dumps that leave out what NES 2.0 spells
+ * out get the usual defaults: 8kB of PRG-RAM, and 8kB of CHR-RAM when
+ * there is no CHR-ROM.
+ */
+struct RomDescriptor {
+  enum class Format : uint8_t {
+    ArchaicINes, // bytes 7 to 15 hold garbage, only the low mapper nibble
+    INes,
+    Nes20
+  };
+
+  enum class Timing : uint8_t { NTSC, PAL, MultiRegion, Dendy };
+
+  Format format = Format::INes;
+  uint16_t mapper_id = 0;
+  uint8_t submapper = 0;
+
+  uint64_t prg_rom_size = 0;
+  uint64_t chr_rom_size = 0;
+  uint64_t prg_ram_size = 0;
+  uint64_t prg_nvram_size = 0; // battery backed
+  uint64_t chr_ram_size = 0;
+  uint64_t chr_nvram_size = 0;
+
+  bool has_trainer = false;
+  bool has_battery = false;
+  bool is_vertical_mirroring = false;
+  bool is_four_screen = false;
+  Timing timing = Timing::NTSC;
+
+  // false for anything that is not a plausible iNES or NES 2.0 header
+  static auto parse(const RomHeader &header, RomDescriptor &descriptor)
+      -> bool;
+
+  // bytes of the file the header accounts for, itself and trainer included
+  auto get_file_size() const -> uint64_t;
+};
+
+#endif // __ROM_HEADER_H__
@@ -0,0 +1,73 @@
+#ifndef __RUN_AHEAD_H__
+#define __RUN_AHEAD_H__
+
+#include "Bus.hpp"
+#include "Cartridge.hpp"
+#include "SaveState.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief Presents frames emulated ahead of the real one to hide input lag
+ *
+ * Each host frame the console runs its real frame without drawing, is
+ * snapshotted, runs the speculative frames with only the last one drawn and
+ * is restored from the snapshot. With a second instance the speculative
+ * frames run from a copy of the snapshot on their own thread while the
+ * console carries on; that picture is only shown on the next host frame, so
+ * the second instance runs one frame further ahead to make up for it.
+ */
+class RunAhead final {
+public:
+  static constexpr uint8_t MaxFrames = 4;
+
+public:
+  RunAhead();
+  ~RunAhead();
+
+  RunAhead(const RunAhead &) = delete;
+  auto operator=(const RunAhead &) -> RunAhead & = delete;
+
+  // number of frames shown ahead of the real one, 0 disables run-ahead
+  auto set_frames(uint8_t frames) -> void;
+  auto get_frames() const -> uint8_t;
+
+  // the second instance needs a cartridge of its own, as cartridges hold
+  // RAM and mapper state; nullptr runs the speculative frames in place
+  auto set_second_instance(const std::shared_ptr<Cartridge> &cartridge)
+      -> void;
+  auto has_second_instance() const -> bool;
+
+  // emulates one real frame of nes and, if is_shown, leaves the picture of
+  // the frame ahead of it in the framebuffer of nes
+  auto run_frame(Bus &nes, bool is_shown) -> void;
+
+private:
+  auto run_in_place(Bus &nes, bool is_shown) -> void;
+  auto run_second_instance(Bus &nes, bool is_shown) -> void;
+  auto work() -> void;
+
+private:
+  uint8_t m_frames = 0;
+  std::unique_ptr<SaveState> m_state = std::make_unique<SaveState>();
+
+  // second instance, fed from the thread calling run_frame
+  std::unique_ptr<Bus> m_second;
+  std::unique_ptr<SaveState> m_second_state = std::make_unique<SaveState>();
+  bool m_has_picture = false;
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_idle;
+  bool m_has_job = false;
+  uint8_t m_job_frames = 0;
+  bool m_is_job_shown = false;
+  bool m_quit = false;
+  std::thread m_worker;
+};
+
+#endif // __RUN_AHEAD_H__
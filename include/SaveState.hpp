@@ -0,0 +1,101 @@
+#ifndef __SAVE_STATE_H__
+#define __SAVE_STATE_H__
+
+/**
+ * @brief Flat, trivially copyable snapshot of the whole console
+ *
+ * Every component copies its mutable state in and out of its own section;
+ * ROM contents are never part of a snapshot. Bump Version whenever the
+ * layout changes, older snapshots are rejected rather than misread.
+ */
+
+#include <array>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <type_traits>
+
+struct CPUState {
+  uint8_t a, x, y, stkp, status;
+  uint16_t pc;
+  uint8_t fetched;
+  uint16_t addr_abs, addr_rel;
+  uint8_t opcode, cycles;
+  uint16_t temp;
+  uint32_t clock_count;
+};
+
+struct PPUState {
+  std::array<std::array<uint8_t, 4096>, 2> table_pattern;
+  std::array<std::array<uint8_t, 1024>, 2> table_name;
+  std::array<uint8_t, 32> table_pallette;
+  std::array<uint8_t, 256> oam;
+
+  uint8_t control, mask, status;
+  uint16_t vram_addr, tram_addr;
+  uint8_t fine_x, address_latch, odd_frame, ppu_data_buffer, oam_addr;
+
+  uint8_t bg_next_tile_id, bg_next_tile_attrib;
+  uint8_t bg_next_tile_lsb, bg_next_tile_msb;
+  uint16_t bg_shifter_pattern_lo, bg_shifter_pattern_hi;
+  uint16_t bg_shifter_attrib_lo, bg_shifter_attrib_hi;
+
+  std::array<uint8_t, 32> sprite_scan_line;
+  uint8_t sprite_count, sprite_zero_selected;
+  std::array<uint8_t, 256> sprite_line;
+  std::array<uint64_t, 4> sprite_mask;
+
+  int16_t scan_line, cycle;
+  uint8_t is_frame_complete, nmi;
+};
+
+// mapper registers, laid out by each mapper as it sees fit
+struct MapperState {
+  std::array<uint8_t, 32> registers;
+};
+
+struct CartridgeState {
+  // identifies the game the snapshot belongs to
+  uint16_t mapper_id;
+  uint8_t prg_banks, chr_banks;
+  MapperState mapper;
+  std::array<uint8_t, 8192> prg_ram;
+  std::array<uint8_t, 32768> chr_ram; // the most any supported board has
+  std::array<uint8_t, 2048> vram; // four-screen nametables
+};
+
+struct BusState {
+  std::array<uint8_t, 2048> cpu_ram;
+  uint32_t system_clock_counter;
+  uint16_t dma_stall_cycles;
+  std::array<uint8_t, 2> controller;
+  std::array<uint8_t, 2> controller_shift;
+  uint8_t controller_strobe;
+};
+
+struct SaveState {
+  static constexpr uint32_t Magic = 0x5641534e; // "NSAV" in file order
+  static constexpr uint32_t Version = 5;
+
+  uint32_t magic = Magic;
+  uint32_t version = Version;
+  uint32_t size = sizeof(SaveState);
+
+  BusState bus;
+  CPUState cpu;
+  PPUState ppu;
+  CartridgeState cartridge;
+
+  auto is_valid() const -> bool;
+
+  // the snapshot is copied, so the caller may reuse it straight away; keep
+  // the future until the write is done, destroying it earlier blocks
+  static auto write_file_async(const SaveState &state,
+                               const std::string &fname) -> std::future<bool>;
+  static auto read_file(const std::string &fname, SaveState &state) -> bool;
+};
+
+static_assert(std::is_trivially_copyable<SaveState>::value,
+              "save states must be copyable with memcpy");
+
+#endif // __SAVE_STATE_H__
@@ -0,0 +1,63 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Work-stealing pool for running many independent tasks at once
+ *
+ * parallel_for deals the indices out round-robin over one queue per thread.
+ * Each thread takes work from the back of its own queue and, once that is
+ * empty, steals from the front of the others, so uneven tasks still keep
+ * every core busy. The calling thread works along as queue 0.
+ */
+class ThreadPool final {
+public:
+  // threads in total, the calling thread included
+  explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  auto operator=(const ThreadPool &) -> ThreadPool & = delete;
+
+  auto get_thread_count() const -> size_t;
+
+  // runs task(i) for every i below count and returns once all are done;
+  // not to be called from several threads at once
+  auto parallel_for(size_t count, const std::function<void(size_t)> &task)
+      -> void;
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<size_t> items;
+  };
+
+  auto work(size_t queue) -> void;
+  auto run_tasks(size_t queue) -> void;
+  auto take(size_t queue, size_t &item) -> bool;
+
+private:
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::vector<std::thread> m_workers;
+
+  const std::function<void(size_t)> *m_task = nullptr;
+  std::atomic<size_t> m_remaining{0};
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  uint64_t m_generation = 0;
+  bool m_quit = false;
+};
+
+#endif // __THREAD_POOL_H__
@@ -0,0 +1,53 @@
+#ifndef __TRIPLE_BUFFER_H__
+#define __TRIPLE_BUFFER_H__
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Lock-free single producer / single consumer triple buffer
+ *
+ * The producer fills the back buffer and publishes it, the consumer picks up
+ * the most recently published buffer. Neither side ever waits on the other;
+ * frames published faster than they are consumed are simply overwritten.
+ */
+template <typename T> class TripleBuffer final {
+public:
+  TripleBuffer() = default;
+  TripleBuffer(const TripleBuffer &) = delete;
+  auto operator=(const TripleBuffer &) -> TripleBuffer & = delete;
+
+  // producer side
+  auto back() -> T & { return m_buffers[m_back]; }
+
+  auto publish() -> void {
+    const uint8_t previous =
+        m_middle.exchange(m_back | IsFresh, std::memory_order_acq_rel);
+    m_back = previous & IndexMask;
+  }
+
+  // consumer side; returns true if a newer buffer became the front one
+  auto update() -> bool {
+    if (!(m_middle.load(std::memory_order_relaxed) & IsFresh)) {
+      return false;
+    }
+    const uint8_t previous =
+        m_middle.exchange(m_front, std::memory_order_acq_rel);
+    m_front = previous & IndexMask;
+    return true;
+  }
+
+  auto front() -> const T & { return m_buffers[m_front]; }
+
+private:
+  static constexpr uint8_t IndexMask = 0x03;
+  static constexpr uint8_t IsFresh = 0x04;
+
+  std::array<T, 3> m_buffers{};
+  uint8_t m_back = 0;  // owned by the producer
+  uint8_t m_front = 1; // owned by the consumer
+  std::atomic<uint8_t> m_middle{2};
+};
+
+#endif // __TRIPLE_BUFFER_H__
@@ -0,0 +1,65 @@
+#include "../include/BatchRunner.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+BatchRunner::BatchRunner(const Cartridge &cartridge, size_t instances,
+                         size_t threads, PPU::PixelFormat format)
+    : m_screen_stride(ScreenSize * PPU::get_bytes_per_pixel(format)),
+      m_ram(instances * RamSize), m_pool(threads) {
+  const size_t stride = m_screen_stride / sizeof(uint32_t);
+  m_screens.resize(instances * stride);
+
+  for (size_t i = 0; i < instances; i++) {
+    auto nes = std::make_unique<Bus>();
+    nes->insert_cartridge(cartridge.clone());
+    nes->m_ppu->set_framebuffer(&m_screens[i * stride], format);
+    nes->reset();
+    m_instances.push_back(std::move(nes));
+  }
+}
+
+auto BatchRunner::get_instance_count() const -> size_t {
+  return m_instances.size();
+}
+
+auto BatchRunner::get_instance(size_t i) -> Bus & { return *m_instances[i]; }
+
+auto BatchRunner::reset() -> void {
+  m_pool.parallel_for(m_instances.size(),
+                      [this](size_t i) { m_instances[i]->reset(); });
+}
+
+auto BatchRunner::step(const std::vector<Input> &inputs, uint32_t frames,
+                       bool is_shown) -> void {
+  m_pool.parallel_for(m_instances.size(), [&](size_t i) {
+    Bus &nes = *m_instances[i];
+    if (i < inputs.size()) {
+      nes.m_controller = inputs[i];
+    }
+
+    for (uint32_t frame = 1; frame <= frames; frame++) {
+      nes.m_ppu->set_pixel_output(is_shown && frame == frames);
+      do {
+        nes.clock();
+      } while (!nes.m_ppu->m_is_frame_complete);
+      nes.m_ppu->m_is_frame_complete = false;
+    }
+    nes.m_ppu->set_pixel_output(true);
+
+    std::memcpy(&m_ram[i * RamSize], nes.m_cpu_ram.data(), RamSize);
+  });
+}
+
+auto BatchRunner::get_screens() const -> const uint8_t * {
+  return reinterpret_cast<const uint8_t *>(m_screens.data());
+}
+
+auto BatchRunner::get_screen_stride() const -> size_t {
+  return m_screen_stride;
+}
+
+auto BatchRunner::get_ram() const -> const uint8_t * { return m_ram.data(); }
@@ -0,0 +1,92 @@
+#include "../include/BatteryRam.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+BatteryRam::BatteryRam(int fd, uint8_t *data, size_t size)
+    : m_fd(fd), m_data(data), m_size(size),
+      m_flusher(&BatteryRam::run_flusher, this) {}
+
+BatteryRam::~BatteryRam() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+  }
+  m_wake.notify_one();
+  m_flusher.join();
+
+  flush();
+  ::munmap(m_data, m_size);
+  ::close(m_fd);
+}
+
+auto BatteryRam::open(const std::string &fname, size_t size)
+    -> std::unique_ptr<BatteryRam> {
+  const int fd = ::open(fname.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  // a longer file is left as it is, only the first size bytes are the RAM
+  struct stat info {};
+  if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) ||
+      (info.st_size < static_cast<off_t>(size) &&
+       ::ftruncate(fd, static_cast<off_t>(size)) != 0)) {
+    ::close(fd);
+    return nullptr;
+  }
+
+  // the descriptor stays open for detaching
+  void *data =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    ::close(fd);
+    return nullptr;
+  }
+  return std::unique_ptr<BatteryRam>(
+      new BatteryRam(fd, static_cast<uint8_t *>(data), size));
+}
+
+auto BatteryRam::flush() -> bool {
+  // only the pages written since the last flush reach the disk
+  return ::msync(m_data, m_size, MS_SYNC) == 0;
+}
+
+auto BatteryRam::detach() -> bool {
+  // a private mapping of the file reads what the shared one wrote so far
+  if (!m_is_detached && remap(MAP_PRIVATE)) {
+    m_is_detached = true;
+  }
+  return m_is_detached;
+}
+
+auto BatteryRam::attach() -> bool {
+  if (m_is_detached && remap(MAP_SHARED)) {
+    m_is_detached = false;
+  }
+  return !m_is_detached;
+}
+
+auto BatteryRam::remap(int flags) -> bool {
+  // replaces the mapping in place, pointers into the RAM stay valid
+  return ::mmap(m_data, m_size, PROT_READ | PROT_WRITE, flags | MAP_FIXED,
+                m_fd, 0) != MAP_FAILED;
+}
+
+auto BatteryRam::run_flusher() -> void {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_wake.wait_for(lock, FlushInterval, [this] { return m_quit; })) {
+    lock.unlock();
+    flush();
+    lock.lock();
+  }
+}
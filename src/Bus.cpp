@@ -1,65 +1,188 @@
-#include "../include/Bus.hpp"
-#include "../include/Cartridge.hpp"
-
-#include <cstdint>
-#include <memory>
-
-Bus::Bus()
-    : m_cpu(std::make_unique<CPU>()),
-      m_ppu(std::make_unique<PPU>()), m_cpu_ram{} {
-  // initialize RAM to 0
-  m_cpu->connect(this);
-}
-
-Bus::~Bus() = default;
-
-auto Bus::write_cpu(uint16_t address, uint8_t data) -> void {
-  if (m_cartridge->write_cpu(address, data)) {
-    // configure for cartridge address range
-  }
-
-  else if (address >= 0x0000 && address <= 0xffff) {
-    m_cpu_ram.at(address & 0x07ff) = data;
-  }
-
-  else if (address >= 0x2000 && address <= 0x3fff) {
-    m_ppu->write_cpu(address & 0x0007, data);
-  }
-}
-
-auto Bus::read_cpu(uint16_t address) -> uint8_t {
-  uint8_t data = 0x00;
-  if (m_cartridge->write_cpu(address, data)) {
-    // configure for cartridge address range
-  }
-
-  else if (address >= 0x0000 && address <= 0x1fff) {
-    return m_cpu_ram.at(address & 0x7ff); // adjusted for RAM mirorring
-  }
-
-  else if (address >= 0x2000 && address <= 0x3fff) {
-    m_ppu->read_cpu(address & 0x0007, data);
-  }
-  return data;
-}
-
-auto Bus::insert_cartridge(const std::shared_ptr<Cartridge> &cartridge)
-    -> void {
-  this->m_cartridge = cartridge;
-  m_ppu->connect(cartridge);
-}
-
-auto Bus::reset() -> void {
-  m_cpu->reset();
-  m_system_clock_counter = 0;
-}
-
-auto Bus::clock() -> void {
-  m_ppu->clock();
-
-  if (m_system_clock_counter % 3 == 0) {
-    m_cpu->clock();
-  }
-
-  m_system_clock_counter += 1;
-}
+#include "../include/Bus.hpp"
+#include "../include/Cartridge.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+Bus::Bus()
+    : m_cpu(std::make_unique<CPU>()),
+      m_ppu(std::make_unique<PPU>()), m_cpu_ram{}, m_controller{} {
+  // initialize RAM to 0
+  m_cpu->connect(this);
+}
+
+Bus::~Bus() = default;
+
+auto Bus::write_cpu(uint16_t address, uint8_t data) -> void {
+  if (m_cartridge->write_cpu(address, data)) {
+    // configure for cartridge address range
+  }
+
+  else if (address >= 0x0000 && address <= 0x1fff) {
+    m_cpu_ram.at(address & 0x07ff) = data;
+  }
+
+  else if (address >= 0x2000 && address <= 0x3fff) {
+    m_ppu->write_cpu(address & 0x0007, data);
+  }
+
+  else if (address == 0x4014) {
+    dma_oam(data);
+  }
+
+  else if (address == 0x4016) {
+    // both ports share the strobe line
+    m_controller_strobe = data & 0x01;
+    if (m_controller_strobe) {
+      m_controller_shift = m_controller;
+    }
+  }
+}
+
+auto Bus::read_cpu(uint16_t address, bool is_read_only) -> uint8_t {
+  uint8_t data = 0x00;
+  if (m_cartridge->read_cpu(address, data)) {
+    // configure for cartridge address range
+  }
+
+  else if (address >= 0x0000 && address <= 0x1fff) {
+    return m_cpu_ram.at(address & 0x7ff); // adjusted for RAM mirorring
+  }
+
+  else if (address >= 0x2000 && address <= 0x3fff) {
+    data = m_ppu->read_cpu(address & 0x0007, is_read_only);
+  }
+
+  else if (address == 0x4016 || address == 0x4017) {
+    const uint8_t port = address & 0x0001;
+    if (m_controller_strobe) {
+      m_controller_shift[port] = m_controller[port];
+    }
+    data = (m_controller_shift[port] & 0x80) ? 0x01 : 0x00;
+    if (!is_read_only) {
+      // official pads return 1 once all eight buttons are read
+      m_controller_shift[port] = (m_controller_shift[port] << 1) | 0x01;
+    }
+  }
+  return data;
+}
+
+auto Bus::dma_oam(uint8_t page) -> void {
+  const uint16_t address = page << 8;
+
+  if (address <= 0x1fff) {
+    // pages never straddle the 2kB RAM mirror
+    m_ppu->write_oam(&m_cpu_ram[address & 0x07ff]);
+  } else if (const uint8_t *rom = m_cartridge->map_cpu_page(address)) {
+    m_ppu->write_oam(rom);
+  } else {
+    // I/O and unmapped pages go through the bus one byte at a time
+    std::array<uint8_t, 256> buffer{};
+    for (uint16_t i = 0; i < 256; i++) {
+      buffer[i] = read_cpu(address + i);
+    }
+    m_ppu->write_oam(buffer.data());
+  }
+
+  // 1 dummy cycle, plus 1 more to align on an odd cycle, then 256 read/write
+  // pairs; the CPU sits idle for all of them. The whole instruction ran on
+  // its first cycle, the write itself lands on its last one
+  const uint32_t write_cycle =
+      m_system_clock_counter / 3 + m_cpu->get_remaining_cycles() - 1;
+  const bool is_odd_cycle = write_cycle & 0x01;
+  m_dma_stall_cycles = 513 + (is_odd_cycle ? 1 : 0);
+}
+
+auto Bus::insert_cartridge(const std::shared_ptr<Cartridge> &cartridge)
+    -> void {
+  this->m_cartridge = cartridge;
+  m_ppu->connect(cartridge);
+}
+
+auto Bus::save_state(SaveState &state) const -> void {
+  state.magic = SaveState::Magic;
+  state.version = SaveState::Version;
+  state.size = sizeof(SaveState);
+
+  state.bus.cpu_ram = m_cpu_ram;
+  state.bus.system_clock_counter = m_system_clock_counter;
+  state.bus.dma_stall_cycles = m_dma_stall_cycles;
+  state.bus.controller = m_controller;
+  state.bus.controller_shift = m_controller_shift;
+  state.bus.controller_strobe = m_controller_strobe;
+  m_cpu->save_state(state.cpu);
+  m_ppu->save_state(state.ppu);
+  m_cartridge->save_state(state.cartridge);
+}
+
+auto Bus::load_state(const SaveState &state) -> bool {
+  if (!state.is_valid() || !m_cartridge->load_state(state.cartridge)) {
+    return false;
+  }
+
+  m_cpu_ram = state.bus.cpu_ram;
+  m_system_clock_counter = state.bus.system_clock_counter;
+  m_dma_stall_cycles = state.bus.dma_stall_cycles;
+  m_controller = state.bus.controller;
+  m_controller_shift = state.bus.controller_shift;
+  m_controller_strobe = state.bus.controller_strobe;
+  m_is_irq_pending = m_cartridge->is_irq_asserted();
+  m_cpu->load_state(state.cpu);
+  m_ppu->load_state(state.ppu);
+  return true;
+}
+
+auto Bus::reset() -> void {
+  m_cpu->reset();
+  m_ppu->reset();
+  m_system_clock_counter = 0;
+  m_dma_stall_cycles = 0;
+}
+
+auto Bus::power_on() -> void {
+  m_cpu_ram.fill(0x00);
+  m_controller.fill(0x00);
+  m_controller_shift.fill(0x00);
+  m_controller_strobe = false;
+  m_is_irq_pending = false;
+  m_cartridge->power_on();
+  m_ppu->power_on();
+  reset();
+}
+
+auto Bus::clock() -> void {
+  m_ppu->clock();
+
+  if (m_system_clock_counter % 3 == 0) {
+    if (m_dma_stall_cycles > 0) {
+      m_dma_stall_cycles -= 1;
+    } else {
+      m_cpu->clock();
+
+      // IRQ is level triggered, it is taken between instructions for as
+      // long as the cartridge holds the line and the I flag allows
+      if (m_is_irq_pending && m_cpu->is_complete()) {
+        if (m_cartridge->is_irq_asserted()) {
+          m_cpu->irq();
+        } else {
+          m_is_irq_pending = false;
+        }
+      }
+    }
+  }
+
+  // the line only needs watching from the dot the cartridge raised it
+  if (m_ppu->m_irq) {
+    m_ppu->m_irq = false;
+    m_is_irq_pending = true;
+  }
+
+  // the PPU raises NMI at the start of vertical blank
+  if (m_ppu->m_nmi) {
+    m_ppu->m_nmi = false;
+    m_cpu->nmi();
+  }
+
+  m_system_clock_counter += 1;
+}
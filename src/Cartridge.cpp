@@ -1,93 +1,278 @@
-#include "../include/Cartridge.hpp"
-#include "../include/Mappers.hpp"
-
-#include <cstdint>
-#include <fstream>
-
-Cartridge::Cartridge(const std::string &fname) : header{} {
-  std::ifstream stream;
-  stream.open(fname, std::ifstream::binary);
-
-  if (stream.is_open()) {
-    // read the file header
-    stream.read((char *)&header, sizeof(Header));
-
-    if (header.mapper_1 & 0x04) {
-      stream.seekg(512, std::ios_base::cur);
-    }
-
-    // set mapper id
-    m_mapper_id = ((header.mapper_2 >> 4) << 4) | (header.mapper_1 >> 4);
-
-    uint8_t ftype = 1;
-
-    if (ftype == 0) {
-    }
-    if (ftype == 1) {
-      m_prg_banks = header.prg_rom_chunks;
-      m_prg_memory.resize(m_prg_banks * 16384);
-      stream.read((char *)m_prg_memory.data(), m_prg_memory.size());
-
-      m_chr_banks = header.chr_rom_chunks;
-      m_chr_memory.resize(m_chr_banks * 8192);
-      stream.read((char *)m_chr_memory.data(), m_chr_memory.size());
-    }
-
-    if (ftype == 2) {
-    }
-
-    // load mapper
-    switch (m_mapper_id) {
-    case 0:
-      m_mapper = std::make_shared<Mapper_000>(m_prg_banks, m_chr_banks);
-      break;
-    }
-
-    m_is_valid_image = true;
-    stream.close();
-  }
-}
-
-auto Cartridge::read_cpu(uint16_t address, uint8_t &data) -> bool {
-
-  uint32_t mapped_addr = 0;
-  if (m_mapper->read_cpu(address, mapped_addr)) {
-    data = m_prg_memory[mapped_addr];
-    return true;
-  }
-
-  return false;
-}
-
-auto Cartridge::write_cpu(uint16_t address, uint8_t data) -> bool {
-  uint32_t mapped_addr = 0;
-  if (m_mapper->write_cpu(address, mapped_addr)) {
-    m_prg_memory[mapped_addr] = data;
-    return true;
-  }
-
-  return false;
-}
-
-auto Cartridge::read_ppu(uint16_t address, uint8_t &data) -> bool {
-
-  uint32_t mapped_addr = 0;
-  if (m_mapper->read_ppu(address, mapped_addr)) {
-    data = m_chr_memory[mapped_addr];
-    return true;
-  }
-
-  return false;
-}
-
-auto Cartridge::write_ppu(uint16_t address, uint8_t data) -> bool {
-  uint32_t mapped_addr = 0;
-  if (m_mapper->write_ppu(address, mapped_addr)) {
-    m_chr_memory[mapped_addr] = data;
-    return true;
-  }
-
-  return false;
-}
-
-auto Cartridge::is_valid_image() -> bool { return m_is_valid_image; }
+#include "../include/Cartridge.hpp"
+#include "../include/Mappers.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+Cartridge::Cartridge(const std::string &fname, const std::string &save_fname)
+    : Cartridge(RomCache::get(fname), save_fname) {}
+
+Cartridge::Cartridge(const uint8_t *data, size_t size)
+    : Cartridge(RomCache::load(data, size)) {}
+
+Cartridge::Cartridge(std::istream &stream)
+    : Cartridge(RomCache::load(stream)) {}
+
+Cartridge::Cartridge(std::shared_ptr<const RomImage> rom,
+                     const std::string &save_fname)
+    : m_rom(std::move(rom)) {
+  if (!m_rom) {
+    return;
+  }
+  const RomDescriptor &descriptor = m_rom->descriptor;
+
+  m_mapper_id = descriptor.mapper_id;
+  m_prg_banks = static_cast<uint8_t>(descriptor.prg_rom_size / 16384);
+  m_chr_banks = static_cast<uint8_t>(descriptor.chr_rom_size / 8192);
+
+  // a snapshot holds 32kB of CHR-RAM, boards with more are refused before
+  // a save file is opened for them
+  if (descriptor.chr_rom_size == 0 &&
+      descriptor.chr_ram_size + descriptor.chr_nvram_size >
+          sizeof(CartridgeState::chr_ram)) {
+    return;
+  }
+
+  // no mapper banks PRG-RAM, so boards get the one 8kB bank at $6000
+  // whatever the header says; a save file that cannot be opened leaves the
+  // game running without saves
+  if (descriptor.prg_ram_size + descriptor.prg_nvram_size > 0) {
+    const size_t size = sizeof(CartridgeState::prg_ram);
+    if (descriptor.has_battery && !save_fname.empty()) {
+      m_battery_ram = BatteryRam::open(save_fname, size);
+    }
+    if (m_battery_ram) {
+      m_prg_ram = m_battery_ram->data();
+    } else {
+      m_prg_ram_storage.resize(size);
+      m_prg_ram = m_prg_ram_storage.data();
+    }
+    m_prg_ram_size = size;
+  }
+
+  // the header decides how much CHR-RAM the board carries, though never
+  // less than the 8kB pattern space the PPU addresses
+  if (descriptor.chr_rom_size == 0) {
+    m_has_chr_ram = true;
+    m_chr_ram.resize(std::max<uint64_t>(
+        descriptor.chr_ram_size + descriptor.chr_nvram_size, 8192));
+    m_tile_generations.resize(m_chr_ram.size() / 16);
+  }
+
+  // the console has RAM for two nametables, four-screen boards the rest
+  if (descriptor.is_four_screen) {
+    m_vram.resize(2048);
+  }
+
+  // banks are no smaller than 8kB of PRG and 1kB of CHR
+  if (descriptor.prg_rom_size == 0 || descriptor.prg_rom_size % 0x2000 != 0 ||
+      descriptor.chr_rom_size % 0x0400 != 0) {
+    return;
+  }
+
+  create_mapper();
+
+  // boards without a mapper are refused here rather than at the first access
+  m_is_valid_image = m_mapper != nullptr;
+}
+
+auto Cartridge::clone() const -> std::shared_ptr<Cartridge> {
+  return std::make_shared<Cartridge>(m_rom);
+}
+
+auto Cartridge::create_mapper() -> void {
+  CartridgeMemory memory;
+  memory.prg_rom = m_rom->prg_rom;
+  memory.prg_rom_size = m_rom->descriptor.prg_rom_size;
+  memory.prg_ram = m_prg_ram;
+  memory.prg_ram_size = m_prg_ram_size;
+  if (m_has_chr_ram) {
+    memory.chr_ram = m_chr_ram.data();
+    memory.chr_ram_size = m_chr_ram.size();
+  } else {
+    memory.chr_rom = m_rom->chr_rom;
+    memory.chr_rom_size = m_rom->descriptor.chr_rom_size;
+  }
+  memory.mirror = m_rom->descriptor.is_vertical_mirroring ? Mirror::Vertical
+                                                          : Mirror::Horizontal;
+  if (!m_vram.empty()) {
+    memory.vram = m_vram.data();
+    memory.mirror = Mirror::FourScreen;
+  }
+
+  m_mapper = MapperFactory::create(m_mapper_id, memory);
+  if (m_mapper) {
+    m_mapper->save_state(m_power_on_mapper);
+  }
+}
+
+auto Cartridge::read_cpu(uint16_t address, uint8_t &data) -> bool {
+  if (const uint8_t *bank = m_mapper->get_cpu_bank(address)) {
+    data = bank[address & 0x1fff];
+    return true;
+  }
+
+  return false;
+}
+
+auto Cartridge::write_cpu(uint16_t address, uint8_t data) -> bool {
+  if (uint8_t *bank = m_mapper->get_cpu_write_bank(address)) {
+    bank[address & 0x1fff] = data;
+    return true;
+  }
+
+  // $4020 is where the cartridge starts
+  return address >= 0x4020 && m_mapper->write_register(address, data);
+}
+
+auto Cartridge::get_tile_version(uint16_t address) const -> TileVersion {
+  const uint8_t *tile = m_mapper->get_ppu_bank(address) + (address & 0x03f0);
+  if (!m_has_chr_ram) {
+    return {tile, 0};
+  }
+  return {tile, m_tile_generations[(tile - m_chr_ram.data()) >> 4]};
+}
+
+auto Cartridge::map_cpu_page(uint16_t address) -> const uint8_t * {
+  // banks are never smaller than a page, so a mapped page is contiguous
+  if (const uint8_t *bank = m_mapper->get_cpu_bank(address)) {
+    return bank + (address & 0x1f00);
+  }
+  return nullptr;
+}
+
+auto Cartridge::read_ppu(uint16_t address, uint8_t &data) -> bool {
+  // every pattern table slot is backed
+  if (address <= 0x1fff) {
+    data = m_mapper->get_ppu_bank(address)[address & 0x03ff];
+    return true;
+  }
+
+  return false;
+}
+
+auto Cartridge::write_ppu(uint16_t address, uint8_t data) -> bool {
+  if (address > 0x1fff) {
+    return false;
+  }
+
+  // CHR-ROM ignores the write
+  if (uint8_t *bank = m_mapper->get_ppu_write_bank(address)) {
+    uint8_t *byte = bank + (address & 0x03ff);
+    *byte = data;
+    m_tile_generations[(byte - m_chr_ram.data()) >> 4]++;
+    return true;
+  }
+
+  return false;
+}
+
+auto Cartridge::connect_ciram(uint8_t *table_0, uint8_t *table_1) -> void {
+  m_mapper->connect_ciram(table_0, table_1);
+}
+
+auto Cartridge::get_name_tables() const -> const std::array<uint8_t *, 4> & {
+  return m_mapper->get_name_tables();
+}
+
+auto Cartridge::is_valid_image() -> bool { return m_is_valid_image; }
+
+auto Cartridge::is_battery_saved() const -> bool {
+  return m_battery_ram != nullptr;
+}
+
+auto Cartridge::detach_battery() -> bool {
+  return !m_battery_ram || m_battery_ram->detach();
+}
+
+auto Cartridge::attach_battery() -> bool {
+  return !m_battery_ram || m_battery_ram->attach();
+}
+
+auto Cartridge::mirror() const -> Mirror { return m_mapper->get_mirror(); }
+
+auto Cartridge::is_irq_asserted() const -> bool {
+  return m_mapper->is_irq_asserted();
+}
+
+auto Cartridge::is_watching_a12() const -> bool {
+  return m_mapper->is_watching_a12();
+}
+
+auto Cartridge::notify_a12_rise() -> void { m_mapper->notify_a12_rise(); }
+
+auto Cartridge::get_descriptor() const -> const RomDescriptor & {
+  static const RomDescriptor none;
+  return m_rom ? m_rom->descriptor : none;
+}
+
+auto Cartridge::save_state(CartridgeState &state) const -> void {
+  state.mapper_id = m_mapper_id;
+  state.prg_banks = m_prg_banks;
+  state.chr_banks = m_chr_banks;
+  m_mapper->save_state(state.mapper);
+  // both RAMs fit a snapshot, larger boards are refused on construction
+  if (m_prg_ram) {
+    std::memcpy(state.prg_ram.data(), m_prg_ram, m_prg_ram_size);
+  }
+  if (m_has_chr_ram) {
+    std::memcpy(state.chr_ram.data(), m_chr_ram.data(), m_chr_ram.size());
+  }
+  if (!m_vram.empty()) {
+    std::memcpy(state.vram.data(), m_vram.data(), m_vram.size());
+  }
+}
+
+auto Cartridge::load_state(const CartridgeState &state) -> bool {
+  // a snapshot only makes sense for the game it was taken from
+  if (state.mapper_id != m_mapper_id || state.prg_banks != m_prg_banks ||
+      state.chr_banks != m_chr_banks) {
+    return false;
+  }
+
+  m_mapper->load_state(state.mapper);
+  if (m_prg_ram) {
+    std::memcpy(m_prg_ram, state.prg_ram.data(), m_prg_ram_size);
+  }
+  if (m_has_chr_ram) {
+    // run-ahead and rewind restore mostly the same tiles every frame, only
+    // those that differ have to be redrawn
+    for (size_t tile = 0; tile < m_tile_generations.size(); tile++) {
+      uint8_t *bytes = m_chr_ram.data() + tile * 16;
+      const uint8_t *saved = state.chr_ram.data() + tile * 16;
+      if (std::memcmp(bytes, saved, 16) != 0) {
+        std::memcpy(bytes, saved, 16);
+        m_tile_generations[tile]++;
+      }
+    }
+  }
+  if (!m_vram.empty()) {
+    std::memcpy(m_vram.data(), state.vram.data(), m_vram.size());
+  }
+  return true;
+}
+
+auto Cartridge::power_on() -> void {
+  if (!m_mapper) {
+    return;
+  }
+
+  m_mapper->load_state(m_power_on_mapper);
+  if (m_prg_ram && !m_battery_ram) {
+    std::fill_n(m_prg_ram, m_prg_ram_size, uint8_t(0x00));
+  }
+  if (m_has_chr_ram) {
+    std::fill(m_chr_ram.begin(), m_chr_ram.end(), uint8_t(0x00));
+    for (auto &generation : m_tile_generations) {
+      generation++;
+    }
+  }
+  std::fill(m_vram.begin(), m_vram.end(), uint8_t(0x00));
+}
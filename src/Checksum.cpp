@@ -0,0 +1,221 @@
+#include "../include/Checksum.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CHECKSUM_HAS_CLMUL 1
+#endif
+
+namespace {
+using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+constexpr auto make_crc_tables() -> CrcTables {
+  CrcTables tables{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+    }
+    tables[0][i] = crc;
+  }
+  for (uint32_t i = 0; i < 256; i++) {
+    for (size_t k = 1; k < 8; k++) {
+      const uint32_t prev = tables[k - 1][i];
+      tables[k][i] = (prev >> 8) ^ tables[0][prev & 0xff];
+    }
+  }
+  return tables;
+}
+
+constexpr CrcTables crc_tables = make_crc_tables();
+
+// works on the inverted crc, like the folding below
+auto crc32_tables(const uint8_t *data, size_t size, uint32_t crc)
+    -> uint32_t {
+  while (size >= 8) {
+    uint32_t low, high;
+    std::memcpy(&low, data, 4);
+    std::memcpy(&high, data + 4, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    low = __builtin_bswap32(low);
+    high = __builtin_bswap32(high);
+#endif
+    low ^= crc;
+    crc = crc_tables[7][low & 0xff] ^ crc_tables[6][(low >> 8) & 0xff] ^
+          crc_tables[5][(low >> 16) & 0xff] ^ crc_tables[4][low >> 24] ^
+          crc_tables[3][high & 0xff] ^ crc_tables[2][(high >> 8) & 0xff] ^
+          crc_tables[1][(high >> 16) & 0xff] ^ crc_tables[0][high >> 24];
+    data += 8;
+    size -= 8;
+  }
+  while (size-- > 0) {
+    crc = (crc >> 8) ^ crc_tables[0][(crc ^ *data++) & 0xff];
+  }
+  return crc;
+}
+
+#ifdef CHECKSUM_HAS_CLMUL
+// x * k, low and high halves each, added to the next 128 bits of data
+__attribute__((target("pclmul"))) auto fold(__m128i x, __m128i k, __m128i next)
+    -> __m128i {
+  const __m128i low = _mm_clmulepi64_si128(x, k, 0x00);
+  const __m128i high = _mm_clmulepi64_si128(x, k, 0x11);
+  return _mm_xor_si128(_mm_xor_si128(high, low), next);
+}
+
+// folds four 128-bit lanes by 64 bytes at a time, then reduces them to 32
+// bits with a Barrett reduction; size is a multiple of 16 and at least 64
+__attribute__((target("pclmul,sse4.1"))) auto
+crc32_clmul(const uint8_t *data, size_t size, uint32_t crc) -> uint32_t {
+  alignas(16) static const uint64_t k1k2[] = {0x0154442bd4, 0x01c6e41596};
+  alignas(16) static const uint64_t k3k4[] = {0x01751997d0, 0x00ccaa009e};
+  alignas(16) static const uint64_t k5k0[] = {0x0163cd6124, 0x0000000000};
+  alignas(16) static const uint64_t poly[] = {0x01db710641, 0x01f7011641};
+
+  const auto load = [](const uint8_t *at) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(at));
+  };
+
+  __m128i x1 = _mm_xor_si128(load(data), _mm_cvtsi32_si128(int(crc)));
+  __m128i x2 = load(data + 0x10);
+  __m128i x3 = load(data + 0x20);
+  __m128i x4 = load(data + 0x30);
+  data += 64;
+  size -= 64;
+
+  __m128i k = _mm_load_si128(reinterpret_cast<const __m128i *>(k1k2));
+  while (size >= 64) {
+    x1 = fold(x1, k, load(data));
+    x2 = fold(x2, k, load(data + 0x10));
+    x3 = fold(x3, k, load(data + 0x20));
+    x4 = fold(x4, k, load(data + 0x30));
+    data += 64;
+    size -= 64;
+  }
+
+  k = _mm_load_si128(reinterpret_cast<const __m128i *>(k3k4));
+  x1 = fold(x1, k, x2);
+  x1 = fold(x1, k, x3);
+  x1 = fold(x1, k, x4);
+  while (size >= 16) {
+    x1 = fold(x1, k, load(data));
+    data += 16;
+    size -= 16;
+  }
+
+  // 128 bits down to 64
+  const __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+  x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+  k = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(k5k0));
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  // and on to 32
+  k = _mm_load_si128(reinterpret_cast<const __m128i *>(poly));
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x10);
+  x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), k, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return uint32_t(_mm_extract_epi32(x1, 1));
+}
+
+auto has_clmul() -> bool {
+  static const bool is_supported = __builtin_cpu_supports("pclmul") &&
+                                   __builtin_cpu_supports("sse4.1");
+  return is_supported;
+}
+#endif
+
+auto rotl(uint32_t value, int bits) -> uint32_t {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+auto sha1_block(std::array<uint32_t, 5> &h, const uint8_t *block) -> void {
+  std::array<uint32_t, 80> w;
+  for (size_t i = 0; i < 16; i++) {
+    w[i] = uint32_t(block[i * 4]) << 24 | uint32_t(block[i * 4 + 1]) << 16 |
+           uint32_t(block[i * 4 + 2]) << 8 | uint32_t(block[i * 4 + 3]);
+  }
+  for (size_t i = 16; i < 80; i++) {
+    w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+  }
+
+  uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+  for (size_t i = 0; i < 80; i++) {
+    uint32_t f, k;
+    if (i < 20) {
+      f = (b & c) | (~b & d);
+      k = 0x5a827999;
+    } else if (i < 40) {
+      f = b ^ c ^ d;
+      k = 0x6ed9eba1;
+    } else if (i < 60) {
+      f = (b & c) | (b & d) | (c & d);
+      k = 0x8f1bbcdc;
+    } else {
+      f = b ^ c ^ d;
+      k = 0xca62c1d6;
+    }
+    const uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+    e = d;
+    d = c;
+    c = rotl(b, 30);
+    b = a;
+    a = temp;
+  }
+
+  h[0] += a;
+  h[1] += b;
+  h[2] += c;
+  h[3] += d;
+  h[4] += e;
+}
+} // namespace
+
+auto Checksum::crc32(const uint8_t *data, size_t size, uint32_t crc)
+    -> uint32_t {
+  crc = ~crc;
+#ifdef CHECKSUM_HAS_CLMUL
+  if (size >= 64 && has_clmul()) {
+    const size_t folded = size & ~size_t(15);
+    crc = crc32_clmul(data, folded, crc);
+    data += folded;
+    size -= folded;
+  }
+#endif
+  return ~crc32_tables(data, size, crc);
+}
+
+auto Checksum::sha1(const uint8_t *data, size_t size) -> Sha1Digest {
+  std::array<uint32_t, 5> h{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476,
+                            0xc3d2e1f0};
+
+  const uint64_t bits = uint64_t(size) * 8;
+  for (; size >= 64; data += 64, size -= 64) {
+    sha1_block(h, data);
+  }
+
+  // the rest, a one bit, zeros and the length in bits fill one or two blocks
+  std::array<uint8_t, 128> tail{};
+  std::memcpy(tail.data(), data, size);
+  tail[size] = 0x80;
+  const size_t tail_size = size + 9 <= 64 ? 64 : 128;
+  for (size_t i = 0; i < 8; i++) {
+    tail[tail_size - 1 - i] = uint8_t(bits >> (i * 8));
+  }
+  for (size_t i = 0; i < tail_size; i += 64) {
+    sha1_block(h, tail.data() + i);
+  }
+
+  Sha1Digest digest;
+  for (size_t i = 0; i < 20; i++) {
+    digest[i] = uint8_t(h[i / 4] >> (24 - (i % 4) * 8));
+  }
+  return digest;
+}
@@ -0,0 +1,104 @@
+#include "../include/FramePacer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ratio>
+#include <thread>
+
+namespace {
+// one frame in seconds: 89341.5 dots at 236.25 / 44 MHz on NTSC, 106392
+// dots at 26.6017125 / 5 MHz on PAL
+using NTSCFrame = std::chrono::duration<int64_t, std::ratio<655171, 39375000>>;
+using PALFrame = std::chrono::duration<int64_t, std::ratio<212784, 10640685>>;
+
+// sleeping is only trusted up to this close to a deadline
+constexpr auto spin_threshold = std::chrono::microseconds(1500);
+} // namespace
+
+FramePacer::FramePacer(Rate rate) : m_rate(rate), m_start(clock::now()) {}
+
+auto FramePacer::set_rate(Rate rate) -> void {
+  m_rate = rate;
+  resync();
+}
+
+auto FramePacer::get_rate() const -> Rate { return m_rate; }
+
+auto FramePacer::get_frame_period() const -> clock::duration {
+  return deadline(1) - deadline(0);
+}
+
+auto FramePacer::get_frequency(Rate rate) -> double {
+  if (rate == Rate::PAL) {
+    return double(PALFrame::period::den) / PALFrame::period::num;
+  }
+  return double(NTSCFrame::period::den) / NTSCFrame::period::num;
+}
+
+auto FramePacer::deadline(uint64_t frame) const -> clock::time_point {
+  switch (m_rate) {
+  case Rate::NTSC:
+    return m_start + std::chrono::duration_cast<clock::duration>(
+                         NTSCFrame(static_cast<int64_t>(frame)));
+  case Rate::PAL:
+    return m_start + std::chrono::duration_cast<clock::duration>(
+                         PALFrame(static_cast<int64_t>(frame)));
+  case Rate::Uncapped:
+    break;
+  }
+  return m_start;
+}
+
+auto FramePacer::wait() -> void {
+  if (m_rate == Rate::Uncapped) {
+    return;
+  }
+
+  m_frame += 1;
+  const auto target = deadline(m_frame);
+  auto now = clock::now();
+
+  // more than a frame behind: start over instead of bursting to catch up
+  if (now - target > get_frame_period()) {
+    m_statistics.resyncs += 1;
+    resync();
+    return;
+  }
+
+  if (target - now > spin_threshold) {
+    std::this_thread::sleep_until(target - spin_threshold);
+  }
+  while ((now = clock::now()) < target) {
+    std::this_thread::yield();
+  }
+
+  record(now - target);
+}
+
+auto FramePacer::resync() -> void {
+  m_start = clock::now();
+  m_frame = 0;
+}
+
+auto FramePacer::record(clock::duration lateness) -> void {
+  const double late_ms =
+      std::chrono::duration<double, std::milli>(lateness).count();
+
+  // Welford's running mean and variance
+  m_statistics.frames += 1;
+  const double delta = late_ms - m_statistics.mean_late_ms;
+  m_statistics.mean_late_ms += delta / m_statistics.frames;
+  m_late_m2 += delta * (late_ms - m_statistics.mean_late_ms);
+
+  m_statistics.jitter_ms = std::sqrt(m_late_m2 / m_statistics.frames);
+  m_statistics.max_late_ms = std::max(m_statistics.max_late_ms, late_ms);
+}
+
+auto FramePacer::get_statistics() const -> Statistics { return m_statistics; }
+
+auto FramePacer::reset_statistics() -> void {
+  m_statistics = Statistics{};
+  m_late_m2 = 0.0;
+}
@@ -0,0 +1,474 @@
+#include "../include/Inflate.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr size_t chunk_size = 64 * 1024;
+
+// room past the end of the output for a literal and the longest match, plus
+// the overshoot of copying it eight bytes at a time
+constexpr size_t output_slack = 1 + 258 + 8;
+
+// table entries: the symbol, or the start of a subtable, above bit 8; the
+// bits to consume, or the index bits of the subtable, below
+constexpr uint32_t sub_table = 0x80;
+constexpr uint32_t invalid_entry = 0xffffu << 8;
+
+constexpr std::array<uint16_t, 29> length_base{
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::array<uint8_t, 29> length_extra{
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+    2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr std::array<uint16_t, 30> distance_base{
+    1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr std::array<uint8_t, 30> distance_extra{
+    0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+auto reverse_bits(uint32_t code, uint8_t count) -> uint32_t {
+  uint32_t reversed = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    reversed = (reversed << 1) | ((code >> i) & 0x01);
+  }
+  return reversed;
+}
+
+// makes room for the next symbol or stored block at the end of out
+auto reserve_output(std::vector<uint8_t> &out, size_t needed) -> bool {
+  if (needed > Inflate::MaxOutput + output_slack) {
+    return false;
+  }
+  // what was reserved is used up before anything is reallocated
+  if (out.size() < needed) {
+    const size_t grown = out.capacity() >= needed
+                             ? out.capacity()
+                             : std::max(out.size() * 2, chunk_size);
+    out.resize(std::max(needed, grown));
+  }
+  return true;
+}
+} // namespace
+
+Inflate::Inflate(const uint8_t *data, size_t size)
+    : m_next(data), m_end(data + size) {}
+
+Inflate::Inflate(Source source) : m_source(std::move(source)) {}
+
+auto Inflate::build_table(const uint8_t *lengths, size_t count,
+                          uint8_t primary_bits, Table &table) -> bool {
+  std::array<uint16_t, 16> counts{};
+  for (size_t i = 0; i < count; i++) {
+    counts[lengths[i]]++;
+  }
+  counts[0] = 0;
+
+  // an over-subscribed code cannot be decoded; an incomplete one leaves
+  // entries that decode to an invalid symbol
+  int32_t left = 1;
+  uint8_t max_length = 0;
+  for (uint8_t length = 1; length < 16; length++) {
+    left = (left << 1) - counts[length];
+    if (left < 0) {
+      return false;
+    }
+    if (counts[length] != 0) {
+      max_length = length;
+    }
+  }
+
+  // symbols in canonical order: by code length, then by value
+  std::array<uint16_t, 16> offsets{};
+  for (uint8_t length = 1; length < 15; length++) {
+    offsets[length + 1] = offsets[length] + counts[length];
+  }
+  std::array<uint16_t, 288> sorted{};
+  for (size_t i = 0; i < count; i++) {
+    if (lengths[i] != 0) {
+      sorted[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+    }
+  }
+
+  // the bits arrive first bit of the code first, so entries are indexed by
+  // the codes reversed; short codes repeat over every index they prefix
+  const uint32_t primary_size = uint32_t(1) << primary_bits;
+  const uint8_t sub_bits =
+      max_length > primary_bits ? max_length - primary_bits : 0;
+  table.primary_bits = primary_bits;
+  table.entries.assign(primary_size, invalid_entry);
+
+  uint32_t code = 0;
+  size_t next = 0;
+  uint32_t prefix = ~0u;
+  size_t sub_start = 0;
+  for (uint8_t length = 1; length <= max_length; length++) {
+    for (uint16_t i = 0; i < counts[length]; i++, code++) {
+      const uint32_t symbol = sorted[next++];
+      const uint32_t reversed = reverse_bits(code, length);
+
+      if (length <= primary_bits) {
+        for (uint32_t index = reversed; index < primary_size;
+             index += uint32_t(1) << length) {
+          table.entries[index] = (symbol << 8) | length;
+        }
+        continue;
+      }
+
+      // longer codes sharing their first bits are consecutive in canonical
+      // order, each run gets one subtable
+      const uint32_t top = code >> (length - primary_bits);
+      if (top != prefix) {
+        prefix = top;
+        sub_start = table.entries.size();
+        table.entries.resize(sub_start + (size_t(1) << sub_bits),
+                             invalid_entry);
+        table.entries[reverse_bits(top, primary_bits)] =
+            (static_cast<uint32_t>(sub_start) << 8) | sub_table | sub_bits;
+      }
+      const uint8_t rest = length - primary_bits;
+      for (uint32_t index = reversed >> primary_bits;
+           index < (uint32_t(1) << sub_bits); index += uint32_t(1) << rest) {
+        table.entries[sub_start + index] = (symbol << 8) | rest;
+      }
+    }
+    code <<= 1;
+  }
+  return true;
+}
+
+auto Inflate::get_fixed_tables() -> const std::pair<Table, Table> & {
+  static const std::pair<Table, Table> tables = [] {
+    std::array<uint8_t, 288> litlen{};
+    std::fill(litlen.begin(), litlen.begin() + 144, 8);
+    std::fill(litlen.begin() + 144, litlen.begin() + 256, 9);
+    std::fill(litlen.begin() + 256, litlen.begin() + 280, 7);
+    std::fill(litlen.begin() + 280, litlen.end(), 8);
+    std::array<uint8_t, 30> dist{};
+    dist.fill(5);
+
+    std::pair<Table, Table> fixed;
+    build_table(litlen.data(), litlen.size(), 10, fixed.first);
+    build_table(dist.data(), dist.size(), 8, fixed.second);
+    return fixed;
+  }();
+  return tables;
+}
+
+auto Inflate::read_chunk() -> bool {
+  if (!m_source) {
+    return false;
+  }
+  m_chunk.resize(chunk_size);
+  const size_t size = m_source(m_chunk.data(), m_chunk.size());
+  m_next = m_chunk.data();
+  m_end = m_next + size;
+  return size != 0;
+}
+
+auto Inflate::fill_bits() -> void {
+  if (m_bit_count >= 56) {
+    return;
+  }
+
+  // whole bytes up to 56 bits or more in one load while the input allows
+  if (m_end - m_next >= 8) {
+    uint64_t word;
+    std::memcpy(&word, m_next, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    const int bytes = (63 - m_bit_count) >> 3;
+    m_bits |= (word & (~uint64_t(0) >> (64 - 8 * bytes))) << m_bit_count;
+    m_next += bytes;
+    m_bit_count += 8 * bytes;
+    return;
+  }
+
+  while (m_bit_count <= 56) {
+    if (m_next == m_end && !read_chunk()) {
+      return;
+    }
+    m_bits |= uint64_t(*m_next++) << m_bit_count;
+    m_bit_count += 8;
+  }
+}
+
+auto Inflate::get_bits(uint8_t count) -> uint32_t {
+  const uint32_t value =
+      static_cast<uint32_t>(m_bits) & ((uint32_t(1) << count) - 1);
+  m_bits >>= count;
+  m_bit_count -= count;
+  return value;
+}
+
+auto Inflate::decode(const Table &table) -> uint32_t {
+  uint32_t entry =
+      table.entries[m_bits & ((uint32_t(1) << table.primary_bits) - 1)];
+  if (entry & sub_table) {
+    m_bits >>= table.primary_bits;
+    m_bit_count -= table.primary_bits;
+    entry = table.entries[(entry >> 8) +
+                          (m_bits & ((uint32_t(1) << (entry & 0x1f)) - 1))];
+  }
+  m_bits >>= entry & 0x1f;
+  m_bit_count -= entry & 0x1f;
+  return entry >> 8;
+}
+
+auto Inflate::inflate(std::vector<uint8_t> &out, size_t expected_size)
+    -> bool {
+  if (expected_size != 0) {
+    out.reserve(out.size() + std::min(expected_size, MaxOutput) +
+                output_slack);
+  }
+
+  // out is grown ahead of the data, size is how much of it is written
+  size_t size = out.size();
+  bool is_last = false;
+  bool is_valid = true;
+
+  while (is_valid && !is_last) {
+    fill_bits();
+    is_last = get_bits(1);
+    switch (get_bits(2)) {
+    case 0:
+      is_valid = inflate_stored(out, size);
+      break;
+    case 1:
+      is_valid = inflate_block(get_fixed_tables().first,
+                               get_fixed_tables().second, out, size);
+      break;
+    case 2:
+      is_valid = read_dynamic_tables() &&
+                 inflate_block(m_litlen, m_dist, out, size);
+      break;
+    default:
+      is_valid = false;
+      break;
+    }
+    is_valid = is_valid && m_bit_count >= 0;
+  }
+
+  out.resize(size);
+  return is_valid;
+}
+
+auto Inflate::read_dynamic_tables() -> bool {
+  static constexpr std::array<uint8_t, 19> order{
+      16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+  fill_bits();
+  const size_t litlen_count = get_bits(5) + 257;
+  const size_t dist_count = get_bits(5) + 1;
+  const size_t code_count = get_bits(4) + 4;
+  if (litlen_count > 286 || dist_count > 30) {
+    return false;
+  }
+
+  // the code lengths are themselves Huffman coded
+  std::array<uint8_t, 19> code_lengths{};
+  for (size_t i = 0; i < code_count; i++) {
+    fill_bits();
+    code_lengths[order[i]] = static_cast<uint8_t>(get_bits(3));
+  }
+  Table code_table;
+  if (!build_table(code_lengths.data(), code_lengths.size(), 7, code_table)) {
+    return false;
+  }
+
+  // one run of lengths for both codes, repeats may cross from one to the
+  // other
+  const size_t total = litlen_count + dist_count;
+  std::array<uint8_t, 286 + 30> lengths{};
+  for (size_t i = 0; i < total;) {
+    fill_bits();
+    if (m_bit_count < 0) {
+      return false;
+    }
+
+    const uint32_t symbol = decode(code_table);
+    if (symbol < 16) {
+      lengths[i++] = static_cast<uint8_t>(symbol);
+      continue;
+    }
+
+    uint8_t value = 0;
+    size_t repeat = 0;
+    if (symbol == 16) {
+      if (i == 0) {
+        return false;
+      }
+      value = lengths[i - 1];
+      repeat = 3 + get_bits(2);
+    } else if (symbol == 17) {
+      repeat = 3 + get_bits(3);
+    } else if (symbol == 18) {
+      repeat = 11 + get_bits(7);
+    } else {
+      return false;
+    }
+    if (i + repeat > total) {
+      return false;
+    }
+    std::fill_n(lengths.begin() + i, repeat, value);
+    i += repeat;
+  }
+
+  // a block without an end code could never finish
+  if (lengths[256] == 0) {
+    return false;
+  }
+  return build_table(lengths.data(), litlen_count, 10, m_litlen) &&
+         build_table(lengths.data() + litlen_count, dist_count, 8, m_dist);
+}
+
+auto Inflate::inflate_stored(std::vector<uint8_t> &out, size_t &size)
+    -> bool {
+  uint8_t header[4];
+  if (!read_bytes(header, sizeof(header))) {
+    return false;
+  }
+  const uint16_t length = header[0] | (header[1] << 8);
+  const uint16_t complement = header[2] | (header[3] << 8);
+  if (length != static_cast<uint16_t>(~complement) ||
+      !reserve_output(out, size + length + output_slack) ||
+      !read_bytes(out.data() + size, length)) {
+    return false;
+  }
+  size += length;
+  return true;
+}
+
+auto Inflate::inflate_block(const Table &litlen, const Table &dist,
+                            std::vector<uint8_t> &out, size_t &size) -> bool {
+  for (;;) {
+    if (size + output_slack > out.size() &&
+        !reserve_output(out, size + output_slack)) {
+      return false;
+    }
+
+    // enough bits for a length and a distance with their extra bits
+    fill_bits();
+    if (m_bit_count < 0) {
+      return false;
+    }
+
+    uint32_t symbol = decode(litlen);
+    if (symbol < 256) {
+      // literals dominate, a second one fits in the bits already loaded
+      out[size++] = static_cast<uint8_t>(symbol);
+      if (m_bit_count < 15) {
+        continue;
+      }
+      symbol = decode(litlen);
+      if (symbol < 256) {
+        out[size++] = static_cast<uint8_t>(symbol);
+        continue;
+      }
+      fill_bits();
+    }
+    if (symbol == 256) {
+      return true;
+    }
+    if (symbol > 285) {
+      return false;
+    }
+
+    const uint32_t length =
+        length_base[symbol - 257] + get_bits(length_extra[symbol - 257]);
+    const uint32_t code = decode(dist);
+    if (code > 29) {
+      return false;
+    }
+    const uint32_t distance =
+        distance_base[code] + get_bits(distance_extra[code]);
+    if (distance > size) {
+      return false;
+    }
+
+    // matches may overlap what they copy; eight bytes at a time only when
+    // each chunk comes from bytes already written
+    uint8_t *to = out.data() + size;
+    const uint8_t *from = to - distance;
+    if (distance >= 8) {
+      for (uint32_t i = 0; i < length; i += 8) {
+        std::memcpy(to + i, from + i, 8);
+      }
+    } else if (distance == 1) {
+      std::memset(to, *from, length);
+    } else {
+      for (uint32_t i = 0; i < length; i++) {
+        to[i] = from[i];
+      }
+    }
+    size += length;
+  }
+}
+
+auto Inflate::read_bytes(uint8_t *data, size_t size) -> bool {
+  if (m_bit_count < 0) {
+    return false;
+  }
+
+  // the rest of a partly read byte is padding
+  const int partial = m_bit_count & 0x07;
+  m_bits >>= partial;
+  m_bit_count -= partial;
+  for (; size > 0 && m_bit_count > 0; size--) {
+    *data++ = static_cast<uint8_t>(m_bits);
+    m_bits >>= 8;
+    m_bit_count -= 8;
+  }
+
+  while (size > 0) {
+    if (m_next == m_end && !read_chunk()) {
+      return false;
+    }
+    const size_t count =
+        std::min(size, static_cast<size_t>(m_end - m_next));
+    std::memcpy(data, m_next, count);
+    m_next += count;
+    data += count;
+    size -= count;
+  }
+  return true;
+}
+
+auto Inflate::skip_bytes(size_t size) -> bool {
+  uint8_t buffer[256];
+  while (size > 0) {
+    const size_t count = std::min(size, sizeof(buffer));
+    if (!read_bytes(buffer, count)) {
+      return false;
+    }
+    size -= count;
+  }
+  return true;
+}
+
+auto Inflate::read_rest(std::vector<uint8_t> &out) -> bool {
+  if (m_bit_count < 0) {
+    return false;
+  }
+  const size_t buffered = static_cast<size_t>(m_bit_count >> 3);
+  const size_t start = out.size();
+  out.resize(start + buffered);
+  read_bytes(out.data() + start, buffered);
+
+  do {
+    if (out.size() + (m_end - m_next) > MaxOutput) {
+      return false;
+    }
+    out.insert(out.end(), m_next, m_end);
+    m_next = m_end;
+  } while (read_chunk());
+  return true;
+}
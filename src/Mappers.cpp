@@ -1,44 +1,440 @@
-#include "../include/Mappers.hpp"
-
-#include <cstdint>
-
-Mapper::Mapper(uint8_t prg_banks, uint8_t char_bank)
-    : m_prg_banks(prg_banks), m_char_banks(char_bank) {}
-
-Mapper_000::Mapper_000(uint8_t prg_banks, uint8_t char_bank)
-    : Mapper(prg_banks, char_bank) {}
-
-auto Mapper_000::read_cpu(uint16_t address, uint32_t &mapped_addr) -> bool {
-  if (address >= 0x8000 && address <= 0xffff) {
-    mapped_addr = address & (m_prg_banks > 1 ? 0x7fff : 0x3fff);
-    return true;
-  }
-  return false;
-}
-
-auto Mapper_000::write_cpu(uint16_t address, uint32_t &mapped_addr) -> bool {
-  if (address >= 0x8000 && address <= 0xffff) {
-    mapped_addr = address & (m_prg_banks > 1 ? 0x7fff : 0x3fff);
-    return true;
-  }
-  return false;
-}
-
-auto Mapper_000::read_ppu(uint16_t address, uint32_t &mapped_addr) -> bool {
-  if (address >= 0x0000 && address <= 0x1fff) {
-    mapped_addr = address;
-    return true;
-  }
-  return false;
-}
-
-auto Mapper_000::write_ppu(uint16_t address, uint32_t &mapped_addr) -> bool {
-  if (address >= 0x0000 && address <= 0x1fff) {
-    if (m_char_banks == 0) {
-      // treated as RAM
-      mapped_addr = address;
-      return true;
-    }
-  }
-  return false;
+#include "../include/Mappers.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+namespace {
+const MapperFactory::Registration<Mapper_000> mapper_000(0);
+const MapperFactory::Registration<Mapper_001> mapper_001(1);
+const MapperFactory::Registration<Mapper_002> mapper_002(2);
+const MapperFactory::Registration<Mapper_003> mapper_003(3);
+const MapperFactory::Registration<Mapper_004> mapper_004(4);
+const MapperFactory::Registration<Mapper_007> mapper_007(7);
+} // namespace
+
+auto MapperFactory::add(uint16_t mapper_id, Create create) -> void {
+  get_registry()[mapper_id] = create;
+}
+
+auto MapperFactory::create(uint16_t mapper_id, const CartridgeMemory &memory)
+    -> std::shared_ptr<Mapper> {
+  const auto &registry = get_registry();
+  const auto entry = registry.find(mapper_id);
+  return entry == registry.end() ? nullptr : entry->second(memory);
+}
+
+auto MapperFactory::is_supported(uint16_t mapper_id) -> bool {
+  return get_registry().count(mapper_id) != 0;
+}
+
+auto MapperFactory::get_registry() -> std::unordered_map<uint16_t, Create> & {
+  static std::unordered_map<uint16_t, Create> registry;
+  return registry;
+}
+
+Mapper::Mapper(const CartridgeMemory &memory)
+    : m_memory(memory), m_mirror(memory.mirror) {
+  // pattern tables are always backed, until the mapper says otherwise by
+  // the first 8kB
+  map_chr_8k(0);
+  if (m_memory.prg_ram) {
+    map_prg_ram(0);
+  }
+
+  if (m_memory.vram) {
+    m_pages[2] = m_memory.vram;
+    m_pages[3] = m_memory.vram + 0x0400;
+  }
+  set_mirror(m_memory.mirror);
+}
+
+auto Mapper::connect_ciram(uint8_t *table_0, uint8_t *table_1) -> void {
+  m_pages[0] = table_0;
+  m_pages[1] = table_1;
+  set_mirror(m_mirror);
+}
+
+auto Mapper::save_state(MapperState &state) const -> void {
+  state.registers.fill(0x00);
+}
+
+auto Mapper::load_state(const MapperState &state) -> void { (void)state; }
+
+auto Mapper::set_mirror(Mirror mirror) -> void {
+  // the page behind $2000, $2400, $2800 and $2c00 for each Mirror
+  static constexpr uint8_t layouts[5][4] = {
+      {0, 0, 1, 1}, {0, 1, 0, 1}, {0, 0, 0, 0}, {1, 1, 1, 1}, {0, 1, 2, 3}};
+
+  if (m_memory.vram) {
+    mirror = Mirror::FourScreen;
+  }
+  m_mirror = mirror;
+  for (size_t i = 0; i < 4; i++) {
+    m_name_tables[i] = m_pages[layouts[static_cast<size_t>(mirror)][i]];
+  }
+}
+
+auto Mapper::map_prg_8k(size_t slot, size_t bank) -> void {
+  const size_t offset = (bank % get_prg_bank_count()) * 0x2000;
+  m_cpu_read[4 + (slot & 0x03)] = m_memory.prg_rom + offset;
+}
+
+auto Mapper::map_prg_16k(size_t slot, size_t bank) -> void {
+  map_prg_8k(slot * 2, bank * 2);
+  map_prg_8k(slot * 2 + 1, bank * 2 + 1);
+}
+
+auto Mapper::map_prg_32k(size_t bank) -> void {
+  map_prg_16k(0, bank * 2);
+  map_prg_16k(1, bank * 2 + 1);
+}
+
+auto Mapper::map_prg_ram(size_t bank) -> void {
+  const size_t offset = (bank % (m_memory.prg_ram_size / 0x2000)) * 0x2000;
+  m_cpu_read[3] = m_memory.prg_ram + offset;
+  m_cpu_write[3] = m_memory.prg_ram + offset;
+}
+
+auto Mapper::map_chr_1k(size_t slot, size_t bank) -> void {
+  const size_t offset = (bank % get_chr_bank_count()) * 0x0400;
+  slot &= 0x07;
+  if (m_memory.chr_ram) {
+    m_ppu_write[slot] = m_memory.chr_ram + offset;
+    m_ppu_read[slot] = m_ppu_write[slot];
+  } else {
+    m_ppu_read[slot] = m_memory.chr_rom + offset;
+  }
+}
+
+auto Mapper::map_chr_4k(size_t slot, size_t bank) -> void {
+  for (size_t i = 0; i < 4; i++) {
+    map_chr_1k(slot * 4 + i, bank * 4 + i);
+  }
+}
+
+auto Mapper::map_chr_8k(size_t bank) -> void {
+  map_chr_4k(0, bank * 2);
+  map_chr_4k(1, bank * 2 + 1);
+}
+
+auto Mapper::get_prg_bank_count() const -> size_t {
+  return m_memory.prg_rom_size / 0x2000;
+}
+
+auto Mapper::get_chr_bank_count() const -> size_t {
+  return (m_memory.chr_ram ? m_memory.chr_ram_size : m_memory.chr_rom_size) /
+         0x0400;
+}
+
+Mapper_000::Mapper_000(const CartridgeMemory &memory) : Mapper(memory) {
+  // 16kB boards mirror their one bank at $c000
+  map_prg_32k(0);
+}
+
+auto Mapper_000::write_register(uint16_t address, uint8_t data) -> bool {
+  // no registers, PRG-ROM ignores the write
+  (void)data;
+  return address >= 0x8000;
+}
+
+Mapper_001::Mapper_001(const CartridgeMemory &memory) : Mapper(memory) {
+  // the last bank is fixed at $c000 on power-up
+  m_control |= memory.mirror == Mirror::Vertical ? 0x02 : 0x03;
+  update_banks();
+}
+
+auto Mapper_001::write_register(uint16_t address, uint8_t data) -> bool {
+  if (address < 0x8000) {
+    return false;
+  }
+
+  // bit 7 resets the shift register and fixes the last bank
+  if (data & 0x80) {
+    m_shift = 0x10;
+    m_control |= 0x0c;
+    update_banks();
+    return true;
+  }
+
+  const bool is_fifth_write = m_shift & 0x01;
+  m_shift = (m_shift >> 1) | ((data & 0x01) << 4);
+  if (is_fifth_write) {
+    switch ((address >> 13) & 0x03) {
+    case 0:
+      m_control = m_shift;
+      break;
+    case 1:
+      m_chr_0 = m_shift;
+      break;
+    case 2:
+      m_chr_1 = m_shift;
+      break;
+    case 3:
+      m_prg = m_shift;
+      break;
+    }
+    m_shift = 0x10;
+    update_banks();
+  }
+  return true;
+}
+
+auto Mapper_001::update_banks() -> void {
+  switch (m_control & 0x03) {
+  case 0:
+    set_mirror(Mirror::OneScreenLo);
+    break;
+  case 1:
+    set_mirror(Mirror::OneScreenHi);
+    break;
+  case 2:
+    set_mirror(Mirror::Vertical);
+    break;
+  case 3:
+    set_mirror(Mirror::Horizontal);
+    break;
+  }
+
+  // 512kB boards (SUROM) pick the 256kB half with a CHR register bit
+  const size_t banks_16k = get_prg_bank_count() / 2;
+  const size_t outer = banks_16k > 16 ? (m_chr_0 & 0x10) : 0;
+  const size_t prg = outer | (m_prg & 0x0f);
+  const size_t last = outer + std::min<size_t>(banks_16k, 16) - 1;
+
+  switch ((m_control >> 2) & 0x03) {
+  case 0:
+  case 1:
+    map_prg_32k(prg >> 1);
+    break;
+  case 2:
+    map_prg_16k(0, outer);
+    map_prg_16k(1, prg);
+    break;
+  case 3:
+    map_prg_16k(0, prg);
+    map_prg_16k(1, last);
+    break;
+  }
+
+  if (m_control & 0x10) {
+    map_chr_4k(0, m_chr_0);
+    map_chr_4k(1, m_chr_1);
+  } else {
+    map_chr_8k(m_chr_0 >> 1);
+  }
+}
+
+auto Mapper_001::save_state(MapperState &state) const -> void {
+  Mapper::save_state(state);
+  state.registers[0] = m_shift;
+  state.registers[1] = m_control;
+  state.registers[2] = m_chr_0;
+  state.registers[3] = m_chr_1;
+  state.registers[4] = m_prg;
+}
+
+auto Mapper_001::load_state(const MapperState &state) -> void {
+  m_shift = state.registers[0];
+  m_control = state.registers[1];
+  m_chr_0 = state.registers[2];
+  m_chr_1 = state.registers[3];
+  m_prg = state.registers[4];
+  update_banks();
+}
+
+Mapper_002::Mapper_002(const CartridgeMemory &memory) : Mapper(memory) {
+  update_banks();
+}
+
+auto Mapper_002::write_register(uint16_t address, uint8_t data) -> bool {
+  if (address < 0x8000) {
+    return false;
+  }
+  m_prg = data;
+  update_banks();
+  return true;
+}
+
+auto Mapper_002::update_banks() -> void {
+  map_prg_16k(0, m_prg);
+  map_prg_16k(1, get_prg_bank_count() / 2 - 1);
+}
+
+auto Mapper_002::save_state(MapperState &state) const -> void {
+  Mapper::save_state(state);
+  state.registers[0] = m_prg;
+}
+
+auto Mapper_002::load_state(const MapperState &state) -> void {
+  m_prg = state.registers[0];
+  update_banks();
+}
+
+Mapper_003::Mapper_003(const CartridgeMemory &memory) : Mapper(memory) {
+  map_prg_32k(0);
+  update_banks();
+}
+
+auto Mapper_003::write_register(uint16_t address, uint8_t data) -> bool {
+  if (address < 0x8000) {
+    return false;
+  }
+  m_chr = data;
+  update_banks();
+  return true;
+}
+
+auto Mapper_003::update_banks() -> void { map_chr_8k(m_chr); }
+
+auto Mapper_003::save_state(MapperState &state) const -> void {
+  Mapper::save_state(state);
+  state.registers[0] = m_chr;
+}
+
+auto Mapper_003::load_state(const MapperState &state) -> void {
+  m_chr = state.registers[0];
+  update_banks();
+}
+
+Mapper_004::Mapper_004(const CartridgeMemory &memory) : Mapper(memory) {
+  m_mirroring = memory.mirror == Mirror::Horizontal ? 0x01 : 0x00;
+  update_banks();
+}
+
+auto Mapper_004::write_register(uint16_t address, uint8_t data) -> bool {
+  if (address < 0x8000) {
+    return false;
+  }
+
+  // each 8kB range holds two registers, told apart by the lowest bit
+  switch (address & 0xe001) {
+  case 0x8000:
+    m_select = data;
+    break;
+  case 0x8001:
+    m_banks[m_select & 0x07] = data;
+    break;
+  case 0xa000:
+    m_mirroring = data & 0x01;
+    break;
+  case 0xa001:
+    // PRG-RAM protection
+    break;
+  case 0xc000:
+    m_irq_latch = data;
+    break;
+  case 0xc001:
+    m_irq_counter = 0;
+    m_is_irq_reload = true;
+    break;
+  case 0xe000:
+    // also acknowledges a pending IRQ
+    m_is_irq_enabled = false;
+    m_is_irq = false;
+    break;
+  case 0xe001:
+    m_is_irq_enabled = true;
+    break;
+  }
+
+  update_banks();
+  return true;
+}
+
+auto Mapper_004::is_watching_a12() const -> bool { return true; }
+
+// once a scanline while rendering, with the usual pattern table setup
+auto Mapper_004::notify_a12_rise() -> void {
+  if (m_irq_counter == 0 || m_is_irq_reload) {
+    m_irq_counter = m_irq_latch;
+    m_is_irq_reload = false;
+  } else {
+    m_irq_counter -= 1;
+  }
+
+  if (m_irq_counter == 0 && m_is_irq_enabled) {
+    m_is_irq = true;
+  }
+}
+
+auto Mapper_004::update_banks() -> void {
+  // PRG mode swaps the switchable bank at $8000 with the fixed one at $c000
+  const size_t last = get_prg_bank_count() - 1;
+  if (m_select & 0x40) {
+    map_prg_8k(0, last - 1);
+    map_prg_8k(2, m_banks[6]);
+  } else {
+    map_prg_8k(0, m_banks[6]);
+    map_prg_8k(2, last - 1);
+  }
+  map_prg_8k(1, m_banks[7]);
+  map_prg_8k(3, last);
+
+  // CHR inversion swaps the 2kB banks with the 1kB ones
+  const size_t invert = (m_select & 0x80) ? 4 : 0;
+  map_chr_1k(0 ^ invert, m_banks[0] & 0xfe);
+  map_chr_1k(1 ^ invert, m_banks[0] | 0x01);
+  map_chr_1k(2 ^ invert, m_banks[1] & 0xfe);
+  map_chr_1k(3 ^ invert, m_banks[1] | 0x01);
+  map_chr_1k(4 ^ invert, m_banks[2]);
+  map_chr_1k(5 ^ invert, m_banks[3]);
+  map_chr_1k(6 ^ invert, m_banks[4]);
+  map_chr_1k(7 ^ invert, m_banks[5]);
+
+  set_mirror((m_mirroring & 0x01) ? Mirror::Horizontal : Mirror::Vertical);
+}
+
+auto Mapper_004::save_state(MapperState &state) const -> void {
+  Mapper::save_state(state);
+  std::copy(m_banks.begin(), m_banks.end(), state.registers.begin());
+  state.registers[8] = m_select;
+  state.registers[9] = m_mirroring;
+  state.registers[10] = m_irq_latch;
+  state.registers[11] = m_irq_counter;
+  state.registers[12] = m_is_irq_reload;
+  state.registers[13] = m_is_irq_enabled;
+  state.registers[14] = m_is_irq;
+}
+
+auto Mapper_004::load_state(const MapperState &state) -> void {
+  std::copy_n(state.registers.begin(), m_banks.size(), m_banks.begin());
+  m_select = state.registers[8];
+  m_mirroring = state.registers[9];
+  m_irq_latch = state.registers[10];
+  m_irq_counter = state.registers[11];
+  m_is_irq_reload = state.registers[12];
+  m_is_irq_enabled = state.registers[13];
+  m_is_irq = state.registers[14];
+  update_banks();
+}
+
+Mapper_007::Mapper_007(const CartridgeMemory &memory) : Mapper(memory) {
+  update_banks();
+}
+
+auto Mapper_007::write_register(uint16_t address, uint8_t data) -> bool {
+  if (address < 0x8000) {
+    return false;
+  }
+  m_bank = data;
+  update_banks();
+  return true;
+}
+
+auto Mapper_007::update_banks() -> void {
+  map_prg_32k(m_bank & 0x07);
+  set_mirror((m_bank & 0x10) ? Mirror::OneScreenHi : Mirror::OneScreenLo);
+}
+
+auto Mapper_007::save_state(MapperState &state) const -> void {
+  Mapper::save_state(state);
+  state.registers[0] = m_bank;
+}
+
+auto Mapper_007::load_state(const MapperState &state) -> void {
+  m_bank = state.registers[0];
+  update_banks();
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "../include/Movie.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+auto Movie::start_from_power_on() -> void {
+  m_start_state.reset();
+  m_inputs.clear();
+}
+
+auto Movie::start_from_state(const SaveState &state) -> void {
+  m_start_state = std::make_unique<SaveState>(state);
+  m_inputs.clear();
+}
+
+auto Movie::record(const Input &input) -> void { m_inputs.push_back(input); }
+
+auto Movie::get_frame_count() const -> size_t { return m_inputs.size(); }
+
+auto Movie::get_input(size_t frame) const -> const Input & {
+  return m_inputs.at(frame);
+}
+
+auto Movie::has_start_state() const -> bool { return m_start_state != nullptr; }
+
+auto Movie::restore_start(Bus &nes) const -> bool {
+  if (m_start_state) {
+    return nes.load_state(*m_start_state);
+  }
+  nes.power_on();
+  return true;
+}
+
+auto Movie::write_file(const std::string &fname) const -> bool {
+  std::ofstream stream(fname, std::ofstream::binary | std::ofstream::trunc);
+  if (!stream.is_open()) {
+    return false;
+  }
+
+  const Header header{Magic, Version, m_start_state ? HasStartState : 0u,
+                      static_cast<uint32_t>(m_inputs.size())};
+  stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  if (m_start_state) {
+    stream.write(reinterpret_cast<const char *>(m_start_state.get()),
+                 sizeof(SaveState));
+  }
+  stream.write(reinterpret_cast<const char *>(m_inputs.data()),
+               m_inputs.size() * sizeof(Input));
+  return stream.good();
+}
+
+auto Movie::read_file(const std::string &fname, Movie &movie) -> bool {
+  std::ifstream stream(fname, std::ifstream::binary);
+  if (!stream.is_open()) {
+    return false;
+  }
+
+  Header header{};
+  stream.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (stream.gcount() != sizeof(header) || header.magic != Magic ||
+      header.version != Version) {
+    return false;
+  }
+
+  std::unique_ptr<SaveState> state;
+  if (header.flags & HasStartState) {
+    state = std::make_unique<SaveState>();
+    stream.read(reinterpret_cast<char *>(state.get()), sizeof(SaveState));
+    if (stream.gcount() != sizeof(SaveState) || !state->is_valid()) {
+      return false;
+    }
+  }
+
+  // the header is not trusted with the allocation, the file has to hold
+  // every frame it claims
+  const std::streampos position = stream.tellg();
+  stream.seekg(0, std::ifstream::end);
+  const std::streamoff remaining = stream.tellg() - position;
+  stream.seekg(position);
+  if (remaining < 0 || uint64_t(remaining) / sizeof(Input) < header.frames) {
+    return false;
+  }
+
+  std::vector<Input> inputs(header.frames);
+  const auto bytes =
+      static_cast<std::streamsize>(inputs.size() * sizeof(Input));
+  stream.read(reinterpret_cast<char *>(inputs.data()), bytes);
+  if (stream.gcount() != bytes) {
+    return false;
+  }
+
+  movie.m_start_state = std::move(state);
+  movie.m_inputs = std::move(inputs);
+  return true;
+}
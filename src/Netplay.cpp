@@ -0,0 +1,184 @@
+#include "../include/Netplay.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace {
+// packet: first frame, frames of the peer received, input count, inputs
+constexpr size_t header_size = 9;
+constexpr size_t max_inputs = 255;
+
+auto write_u32(std::vector<uint8_t> &out, uint32_t value) -> void {
+  for (int i = 0; i < 4; i++) {
+    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+auto read_u32(const uint8_t *in) -> uint32_t {
+  return uint32_t(in[0]) | uint32_t(in[1]) << 8 | uint32_t(in[2]) << 16 |
+         uint32_t(in[3]) << 24;
+}
+} // namespace
+
+LoopbackTransport::LoopbackTransport(std::shared_ptr<Channel> outgoing,
+                                     std::shared_ptr<Channel> incoming,
+                                     clock::duration latency)
+    : m_outgoing(std::move(outgoing)), m_incoming(std::move(incoming)),
+      m_latency(latency) {}
+
+auto LoopbackTransport::create_pair(clock::duration latency)
+    -> std::pair<std::unique_ptr<LoopbackTransport>,
+                 std::unique_ptr<LoopbackTransport>> {
+  auto a_to_b = std::make_shared<Channel>();
+  auto b_to_a = std::make_shared<Channel>();
+  return {std::unique_ptr<LoopbackTransport>(
+              new LoopbackTransport(a_to_b, b_to_a, latency)),
+          std::unique_ptr<LoopbackTransport>(
+              new LoopbackTransport(b_to_a, a_to_b, latency))};
+}
+
+auto LoopbackTransport::send(const std::vector<uint8_t> &packet) -> void {
+  std::lock_guard<std::mutex> lock(m_outgoing->mutex);
+  m_outgoing->packets.emplace_back(clock::now() + m_latency, packet);
+}
+
+auto LoopbackTransport::receive(std::vector<uint8_t> &packet) -> bool {
+  std::lock_guard<std::mutex> lock(m_incoming->mutex);
+  if (m_incoming->packets.empty() ||
+      m_incoming->packets.front().first > clock::now()) {
+    return false;
+  }
+  packet = std::move(m_incoming->packets.front().second);
+  m_incoming->packets.pop_front();
+  return true;
+}
+
+RollbackSession::RollbackSession(Bus &nes,
+                                 std::unique_ptr<Transport> transport,
+                                 uint8_t local_port)
+    : m_nes(nes), m_transport(std::move(transport)),
+      m_local_port(local_port & 0x01) {
+  for (auto &snapshot : m_snapshots) {
+    snapshot = std::make_unique<SaveState>();
+  }
+}
+
+auto RollbackSession::advance(uint8_t local_input, bool is_shown) -> bool {
+  poll();
+
+  if (m_frame >= m_remote.size() + MaxRollback) {
+    m_statistics.stalls += 1;
+    send_inputs();
+    return false;
+  }
+
+  m_local.push_back(local_input);
+  send_inputs();
+
+  m_used_remote.push_back(predict_remote(m_frame));
+  simulate(m_frame, is_shown);
+  m_frame += 1;
+  return true;
+}
+
+auto RollbackSession::poll() -> void {
+  const uint32_t confirmed = get_confirmed_frame();
+
+  while (m_transport->receive(m_packet)) {
+    if (m_packet.size() < header_size) {
+      continue;
+    }
+    const uint32_t first = read_u32(&m_packet[0]);
+    const uint32_t ack = read_u32(&m_packet[4]);
+    const size_t count =
+        std::min<size_t>(m_packet[8], m_packet.size() - header_size);
+
+    m_peer_ack = std::max(m_peer_ack, std::min<uint32_t>(ack, m_local.size()));
+    // only contiguous inputs are kept, gaps are filled by later resends
+    for (size_t i = 0; i < count; i++) {
+      if (first + i == m_remote.size()) {
+        m_remote.push_back(m_packet[header_size + i]);
+      }
+    }
+  }
+
+  // the first frame that ran with a wrong prediction
+  const uint32_t end = std::min<uint32_t>(m_remote.size(), m_frame);
+  for (uint32_t frame = confirmed; frame < end; frame++) {
+    if (m_used_remote[frame] != m_remote[frame]) {
+      rollback(frame);
+      break;
+    }
+  }
+}
+
+auto RollbackSession::get_frame() const -> uint32_t { return m_frame; }
+
+auto RollbackSession::get_confirmed_frame() const -> uint32_t {
+  return std::min<uint32_t>(m_remote.size(), m_frame);
+}
+
+auto RollbackSession::get_statistics() const -> Statistics {
+  return m_statistics;
+}
+
+auto RollbackSession::predict_remote(uint32_t frame) const -> uint8_t {
+  if (frame < m_remote.size()) {
+    return m_remote[frame];
+  }
+  // players mostly keep holding what they held
+  return m_remote.empty() ? 0x00 : m_remote.back();
+}
+
+auto RollbackSession::simulate(uint32_t frame, bool is_shown) -> void {
+  m_nes.save_state(*m_snapshots[frame % m_snapshots.size()]);
+
+  m_nes.m_controller[m_local_port] = m_local[frame];
+  m_nes.m_controller[m_local_port ^ 0x01] = m_used_remote[frame];
+  m_nes.m_ppu->set_pixel_output(is_shown);
+  do {
+    m_nes.clock();
+  } while (!m_nes.m_ppu->m_is_frame_complete);
+  m_nes.m_ppu->m_is_frame_complete = false;
+  m_nes.m_ppu->set_pixel_output(true);
+}
+
+auto RollbackSession::rollback(uint32_t frame) -> void {
+  const auto start = std::chrono::steady_clock::now();
+
+  m_nes.load_state(*m_snapshots[frame % m_snapshots.size()]);
+  for (uint32_t replay = frame; replay < m_frame; replay++) {
+    m_used_remote[replay] = predict_remote(replay);
+    simulate(replay, false);
+  }
+
+  const uint32_t frames = m_frame - frame;
+  const double elapsed_ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+  m_statistics.rollbacks += 1;
+  m_statistics.resimulated_frames += frames;
+  m_statistics.max_rollback_frames =
+      std::max(m_statistics.max_rollback_frames, frames);
+  m_statistics.max_rollback_ms =
+      std::max(m_statistics.max_rollback_ms, elapsed_ms);
+}
+
+auto RollbackSession::send_inputs() -> void {
+  const uint32_t first = m_peer_ack;
+  const size_t count = std::min(m_local.size() - first, max_inputs);
+
+  m_packet.clear();
+  write_u32(m_packet, first);
+  write_u32(m_packet, static_cast<uint32_t>(m_remote.size()));
+  m_packet.push_back(static_cast<uint8_t>(count));
+  m_packet.insert(m_packet.end(), m_local.begin() + first,
+                  m_local.begin() + first + count);
+  m_transport->send(m_packet);
+}
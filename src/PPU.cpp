@@ -1,90 +1,1117 @@
-#include "../include/PPU.hpp"
-#include "../include/Cartridge.hpp"
-#include "../include/olcPixelGameEngine.hpp"
-
-#include <cstdint>
-#include <memory>
-
-auto PPU::read_cpu(uint16_t address, bool is_read_only = false) -> uint8_t {
-
-  uint8_t data = 0x00;
-
-  switch (static_cast<PPUConstants>(address)) {
-  case PPUConstants::Control:
-    break;
-  case PPUConstants::Mask:
-    break;
-  case PPUConstants::PStatus:
-    break;
-  case PPUConstants::OAM_Address:
-    break;
-  case PPUConstants::OAM_Data:
-    break;
-  case PPUConstants::Scroll:
-    break;
-  case PPUConstants::PPU_Address:
-    break;
-  case PPUConstants::PPU_Data:
-    break;
-  };
-  return data;
-}
-
-auto PPU::write_cpu(uint16_t address, uint8_t data) -> void {
-  switch (static_cast<PPUConstants>(address)) {
-  case PPUConstants::Control:
-    break;
-  case PPUConstants::Mask:
-    break;
-  case PPUConstants::PStatus:
-    break;
-  case PPUConstants::OAM_Address:
-    break;
-  case PPUConstants::OAM_Data:
-    break;
-  case PPUConstants::Scroll:
-    break;
-  case PPUConstants::PPU_Address:
-    break;
-  case PPUConstants::PPU_Data:
-    break;
-  };
-}
-
-auto PPU::read_ppu(uint16_t address, bool is_read_only = false) -> uint8_t {
-  uint8_t data = 0x00l;
-  address &= 0x3fff;
-
-  return data;
-}
-
-auto PPU::write_ppu(uint16_t address, uint8_t data) -> void {
-  address &= 0x3fff;
-}
-
-auto PPU::connect(const std::shared_ptr<Cartridge> &cartridge) -> void {
-  this->m_cartridge = cartridge;
-}
-
-auto PPU::clock() -> void {
-  m_cycle++;
-  if (m_cycle >= 341) {
-    m_cycle = 0;
-    m_scan_line += 1;
-
-    if (m_scan_line >= 261) {
-      m_scan_line -= 1;
-      m_is_frame_complete = true;
-    }
-  }
-}
-
-auto PPU::get_screen() -> olc::Sprite & { return m_screen; }
-
-auto PPU::get_table_name(uint8_t i) -> olc::Sprite & {
-  return m_spr_table_name.at(i);
-}
-
-auto PPU::get_table_pattern(uint8_t i) -> olc::Sprite & {
-  return m_spr_table_pattern.at(i);
+#include "../include/PPU.hpp"
+#include "../include/Cartridge.hpp"
+#include "../include/olcPixelGameEngine.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace {
+constexpr auto rgb(uint8_t r, uint8_t g, uint8_t b) -> uint32_t {
+  return 0xff000000u | (uint32_t(b) << 16) | (uint32_t(g) << 8) | r;
+}
+
+// swaps the R and B channels of a packed RGBA pixel
+constexpr auto to_bgra(uint32_t rgba) -> uint32_t {
+  return (rgba & 0xff00ff00u) | ((rgba >> 16) & 0xffu) | ((rgba & 0xffu) << 16);
+}
+
+constexpr std::array<uint32_t, 64> default_palette{
+    rgb(84, 84, 84),    rgb(0, 30, 116),    rgb(8, 16, 144),
+    rgb(48, 0, 136),    rgb(68, 0, 100),    rgb(92, 0, 48),
+    rgb(84, 4, 0),      rgb(60, 24, 0),     rgb(32, 42, 0),
+    rgb(8, 58, 0),      rgb(0, 64, 0),      rgb(0, 60, 0),
+    rgb(0, 50, 60),     rgb(0, 0, 0),       rgb(0, 0, 0),
+    rgb(0, 0, 0),
+
+    rgb(152, 150, 152), rgb(8, 76, 196),    rgb(48, 50, 236),
+    rgb(92, 30, 228),   rgb(136, 20, 176),  rgb(160, 20, 100),
+    rgb(152, 34, 32),   rgb(120, 60, 0),    rgb(84, 90, 0),
+    rgb(40, 114, 0),    rgb(8, 124, 0),     rgb(0, 118, 40),
+    rgb(0, 102, 120),   rgb(0, 0, 0),       rgb(0, 0, 0),
+    rgb(0, 0, 0),
+
+    rgb(236, 238, 236), rgb(76, 154, 236),  rgb(120, 124, 236),
+    rgb(176, 98, 236),  rgb(228, 84, 236),  rgb(236, 88, 180),
+    rgb(236, 106, 100), rgb(212, 136, 32),  rgb(160, 170, 0),
+    rgb(116, 196, 0),   rgb(76, 208, 32),   rgb(56, 204, 108),
+    rgb(56, 180, 204),  rgb(60, 60, 60),    rgb(0, 0, 0),
+    rgb(0, 0, 0),
+
+    rgb(236, 238, 236), rgb(168, 204, 236), rgb(188, 188, 236),
+    rgb(212, 178, 236), rgb(236, 174, 236), rgb(236, 174, 212),
+    rgb(236, 180, 176), rgb(228, 196, 144), rgb(204, 210, 120),
+    rgb(180, 222, 120), rgb(168, 226, 144), rgb(152, 226, 180),
+    rgb(160, 214, 228), rgb(160, 162, 160), rgb(0, 0, 0),
+    rgb(0, 0, 0)};
+
+// each emphasis bit (red, green, blue) darkens the other two channels
+constexpr auto emphasise(uint32_t rgba, uint8_t emphasis) -> uint32_t {
+  uint32_t result = 0xff000000u;
+  for (int channel = 0; channel < 3; channel++) {
+    uint32_t value = (rgba >> (channel * 8)) & 0xffu;
+    for (int bit = 0; bit < 3; bit++) {
+      if (((emphasis >> bit) & 0x01) && bit != channel) {
+        value = value * 209 / 256;
+      }
+    }
+    result |= value << (channel * 8);
+  }
+  return result;
+}
+
+constexpr auto make_colour_table(const std::array<uint32_t, 64> &palette,
+                                 bool is_bgra) -> PPU::ColourTable {
+  PPU::ColourTable table{};
+  for (uint8_t emphasis = 0; emphasis < 8; emphasis++) {
+    for (uint8_t colour = 0; colour < 64; colour++) {
+      const uint32_t rgba = emphasise(palette[colour], emphasis);
+      table[(emphasis << 6) | colour] = is_bgra ? to_bgra(rgba) : rgba;
+    }
+  }
+  return table;
+}
+
+constexpr PPU::ColourTable default_rgba =
+    make_colour_table(default_palette, false);
+constexpr PPU::ColourTable default_bgra =
+    make_colour_table(default_palette, true);
+} // namespace
+
+PPU::ColourTable PPU::s_colours_rgba = default_rgba;
+PPU::ColourTable PPU::s_colours_bgra = default_bgra;
+
+namespace {
+constexpr int32_t frame_dots = 262 * 341;
+// the MMC3 ignores A12 rises after fewer dots low than this, which keeps
+// the short lows between background fetches from counting
+constexpr int32_t a12_filter_dots = 10;
+} // namespace
+
+PPU::PPU() { invalidate_debug_views(); }
+
+auto PPU::read_cpu(uint16_t address, bool is_read_only) -> uint8_t {
+
+  uint8_t data = 0x00;
+
+  if (is_read_only) {
+    // inspecting the registers must not disturb their state
+    switch (static_cast<PPUConstants>(address)) {
+    case PPUConstants::Control:
+      data = m_control;
+      break;
+    case PPUConstants::Mask:
+      data = m_mask;
+      break;
+    case PPUConstants::PStatus:
+      data = m_status;
+      break;
+    case PPUConstants::OAM_Address:
+      data = m_oam_addr;
+      break;
+    case PPUConstants::OAM_Data:
+      data = m_oam[m_oam_addr];
+      if ((m_oam_addr & 0x03) == 0x02) {
+        data &= ~SpriteFlags::Unimplemented;
+      }
+      break;
+    default:
+      break;
+    }
+    return data;
+  }
+
+  switch (static_cast<PPUConstants>(address)) {
+  case PPUConstants::Control:
+    break;
+  case PPUConstants::Mask:
+    break;
+  case PPUConstants::PStatus:
+    // the unused low bits return whatever was last left on the data bus
+    data = (m_status & 0xe0) | (m_ppu_data_buffer & 0x1f);
+    m_status &= ~StatusFlags::VerticalBlank;
+    m_address_latch = 0;
+    break;
+  case PPUConstants::OAM_Address:
+    break;
+  case PPUConstants::OAM_Data:
+    data = m_oam[m_oam_addr];
+    // attribute bits 2-4 do not exist in OAM and always read back as 0
+    if ((m_oam_addr & 0x03) == 0x02) {
+      data &= ~SpriteFlags::Unimplemented;
+    }
+    break;
+  case PPUConstants::Scroll:
+    break;
+  case PPUConstants::PPU_Address:
+    break;
+  case PPUConstants::PPU_Data:
+    // reads are delayed by one access, except for the palette
+    if (m_is_watching_a12) {
+      track_a12(m_vram_addr & 0x1000);
+    }
+    data = m_ppu_data_buffer;
+    m_ppu_data_buffer = read_ppu(m_vram_addr);
+    if (m_vram_addr >= 0x3f00) {
+      data = m_ppu_data_buffer;
+    }
+    m_vram_addr += (m_control & ControlFlags::IncrementMode) ? 32 : 1;
+    break;
+  };
+  return data;
+}
+
+auto PPU::write_cpu(uint16_t address, uint8_t data) -> void {
+  switch (static_cast<PPUConstants>(address)) {
+  case PPUConstants::Control:
+    if ((m_control ^ data) & ControlFlags::PatternBackground) {
+      m_name_dirty[0].set();
+      m_name_dirty[1].set();
+    }
+    m_control = data;
+    m_tram_addr = (m_tram_addr & ~0x0c00) | ((data & 0x03) << 10);
+    update_a12_watch();
+    break;
+  case PPUConstants::Mask:
+    m_mask = data;
+    update_a12_watch();
+    break;
+  case PPUConstants::PStatus:
+    break;
+  case PPUConstants::OAM_Address:
+    m_oam_addr = data;
+    break;
+  case PPUConstants::OAM_Data:
+    m_oam[m_oam_addr] = data;
+    m_oam_addr += 1;
+    break;
+  case PPUConstants::Scroll:
+    if (m_address_latch == 0) {
+      m_fine_x = data & 0x07;
+      m_tram_addr = (m_tram_addr & ~0x001f) | (data >> 3);
+      m_address_latch = 1;
+    } else {
+      m_tram_addr = (m_tram_addr & ~0x73e0) | ((data & 0x07) << 12) |
+                    ((data >> 3) << 5);
+      m_address_latch = 0;
+    }
+    break;
+  case PPUConstants::PPU_Address:
+    if (m_address_latch == 0) {
+      m_tram_addr = ((data & 0x3f) << 8) | (m_tram_addr & 0x00ff);
+      m_address_latch = 1;
+    } else {
+      m_tram_addr = (m_tram_addr & 0xff00) | data;
+      m_vram_addr = m_tram_addr;
+      m_address_latch = 0;
+      // the new address goes out on the bus, and the MMC3 sees it
+      if (m_is_watching_a12) {
+        track_a12(m_vram_addr & 0x1000);
+      }
+    }
+    break;
+  case PPUConstants::PPU_Data:
+    if (m_is_watching_a12) {
+      track_a12(m_vram_addr & 0x1000);
+    }
+    write_ppu(m_vram_addr, data);
+    m_vram_addr += (m_control & ControlFlags::IncrementMode) ? 32 : 1;
+    break;
+  };
+}
+
+auto PPU::read_ppu(uint16_t address, bool is_read_only) -> uint8_t {
+  (void)is_read_only;
+  uint8_t data = 0x00;
+  address &= 0x3fff;
+
+  if (m_cartridge && m_cartridge->read_ppu(address, data)) {
+    // pattern memory provided by the cartridge
+  }
+
+  else if (address <= 0x1fff) {
+    data = table_pattern[(address & 0x1000) >> 12][address & 0x0fff];
+  }
+
+  else if (address <= 0x3eff) {
+    data = read_name(address);
+  }
+
+  else {
+    address &= 0x001f;
+    // the backdrop entries of the sprite palettes mirror the background ones
+    if ((address & 0x0013) == 0x0010) {
+      address &= 0x000f;
+    }
+    data = table_pallette[address];
+  }
+
+  return data;
+}
+
+auto PPU::write_ppu(uint16_t address, uint8_t data) -> void {
+  address &= 0x3fff;
+
+  if (m_cartridge && m_cartridge->write_ppu(address, data)) {
+    // pattern memory provided by the cartridge
+  }
+
+  else if (address <= 0x1fff) {
+    table_pattern[(address & 0x1000) >> 12][address & 0x0fff] = data;
+  }
+
+  else if (address <= 0x3eff) {
+    uint8_t *page = (*m_name_tables)[(address >> 10) & 0x03];
+    page[address & 0x03ff] = data;
+    // the views show the console's own two tables
+    for (uint8_t table = 0; table < 2; table++) {
+      if (page == table_name[table].data()) {
+        mark_name_dirty(table, address & 0x03ff);
+      }
+    }
+  }
+
+  else {
+    address &= 0x001f;
+    if ((address & 0x0013) == 0x0010) {
+      address &= 0x000f;
+    }
+    // games rewrite the whole palette every frame, mostly unchanged
+    if (table_pallette[address] != data) {
+      table_pallette[address] = data;
+      mark_palette_dirty(address);
+    }
+  }
+}
+
+auto PPU::read_name(uint16_t address) const -> uint8_t {
+  return (*m_name_tables)[(address >> 10) & 0x03][address & 0x03ff];
+}
+
+auto PPU::connect(const std::shared_ptr<Cartridge> &cartridge) -> void {
+  this->m_cartridge = cartridge;
+  if (m_cartridge) {
+    m_cartridge->connect_ciram(table_name[0].data(), table_name[1].data());
+    m_name_tables = &m_cartridge->get_name_tables();
+  }
+  update_a12_watch();
+}
+
+auto PPU::write_oam(const uint8_t *page) -> void {
+  // the copy starts at OAMADDR and wraps around, leaving OAMADDR unchanged
+  const size_t head = 256 - m_oam_addr;
+  std::memcpy(&m_oam[m_oam_addr], page, head);
+  std::memcpy(&m_oam[0], page + head, m_oam_addr);
+}
+
+auto PPU::save_state(PPUState &state) const -> void {
+  state.table_pattern = table_pattern;
+  state.table_name = table_name;
+  state.table_pallette = table_pallette;
+  state.oam = m_oam;
+  state.control = m_control;
+  state.mask = m_mask;
+  state.status = m_status;
+  state.vram_addr = m_vram_addr;
+  state.tram_addr = m_tram_addr;
+  state.fine_x = m_fine_x;
+  state.address_latch = m_address_latch;
+  state.odd_frame = m_odd_frame;
+  state.ppu_data_buffer = m_ppu_data_buffer;
+  state.oam_addr = m_oam_addr;
+  state.bg_next_tile_id = m_bg_next_tile_id;
+  state.bg_next_tile_attrib = m_bg_next_tile_attrib;
+  state.bg_next_tile_lsb = m_bg_next_tile_lsb;
+  state.bg_next_tile_msb = m_bg_next_tile_msb;
+  state.bg_shifter_pattern_lo = m_bg_shifter_pattern_lo;
+  state.bg_shifter_pattern_hi = m_bg_shifter_pattern_hi;
+  state.bg_shifter_attrib_lo = m_bg_shifter_attrib_lo;
+  state.bg_shifter_attrib_hi = m_bg_shifter_attrib_hi;
+  std::memcpy(state.sprite_scan_line.data(), m_sprite_scan_line.data(),
+              sizeof(state.sprite_scan_line));
+  state.sprite_count = m_sprite_count;
+  state.sprite_zero_selected = m_sprite_zero_selected;
+  state.sprite_line = m_sprite_line;
+  state.sprite_mask = m_sprite_mask;
+  state.scan_line = m_scan_line;
+  state.cycle = m_cycle;
+  state.is_frame_complete = m_is_frame_complete;
+  state.nmi = m_nmi;
+}
+
+auto PPU::load_state(const PPUState &state) -> void {
+  // run-ahead and rewind load a snapshot every frame, the debug views only
+  // redraw what it changes
+  for (uint8_t table = 0; table < 2; table++) {
+    if (table_name[table] == state.table_name[table]) {
+      continue;
+    }
+    for (uint16_t offset = 0; offset < 1024; offset++) {
+      if (table_name[table][offset] != state.table_name[table][offset]) {
+        mark_name_dirty(table, offset);
+      }
+    }
+  }
+  if ((m_control ^ state.control) & ControlFlags::PatternBackground) {
+    m_name_dirty[0].set();
+    m_name_dirty[1].set();
+  }
+  const auto pallette = table_pallette;
+
+  table_pattern = state.table_pattern;
+  table_name = state.table_name;
+  table_pallette = state.table_pallette;
+  m_oam = state.oam;
+  m_control = state.control;
+  m_mask = state.mask;
+  m_status = state.status;
+  m_vram_addr = state.vram_addr;
+  m_tram_addr = state.tram_addr;
+  m_fine_x = state.fine_x;
+  m_address_latch = state.address_latch;
+  m_odd_frame = state.odd_frame;
+  m_ppu_data_buffer = state.ppu_data_buffer;
+  m_oam_addr = state.oam_addr;
+  m_bg_next_tile_id = state.bg_next_tile_id;
+  m_bg_next_tile_attrib = state.bg_next_tile_attrib;
+  m_bg_next_tile_lsb = state.bg_next_tile_lsb;
+  m_bg_next_tile_msb = state.bg_next_tile_msb;
+  m_bg_shifter_pattern_lo = state.bg_shifter_pattern_lo;
+  m_bg_shifter_pattern_hi = state.bg_shifter_pattern_hi;
+  m_bg_shifter_attrib_lo = state.bg_shifter_attrib_lo;
+  m_bg_shifter_attrib_hi = state.bg_shifter_attrib_hi;
+  std::memcpy(m_sprite_scan_line.data(), state.sprite_scan_line.data(),
+              sizeof(m_sprite_scan_line));
+  m_sprite_count = state.sprite_count;
+  m_sprite_zero_selected = state.sprite_zero_selected;
+  m_sprite_line = state.sprite_line;
+  m_sprite_mask = state.sprite_mask;
+  m_scan_line = state.scan_line;
+  m_cycle = state.cycle;
+  m_is_frame_complete = state.is_frame_complete;
+  m_nmi = state.nmi;
+
+  // states are taken between frames, when A12 has been low since vblank
+  m_a12 = false;
+  m_a12_fall_at = get_dot_position() - frame_dots / 2;
+  update_a12_watch();
+
+  for (uint8_t address = 0; address < 32; address++) {
+    if (pallette[address] != table_pallette[address]) {
+      mark_palette_dirty(address);
+    }
+  }
+}
+
+auto PPU::reset() -> void {
+  m_control = 0x00;
+  m_mask = 0x00;
+  m_status = 0x00;
+  m_vram_addr = 0x0000;
+  m_tram_addr = 0x0000;
+  m_fine_x = 0x00;
+  m_address_latch = 0x00;
+  m_odd_frame = false;
+  m_ppu_data_buffer = 0x00;
+  m_bg_next_tile_id = 0x00;
+  m_bg_next_tile_attrib = 0x00;
+  m_bg_next_tile_lsb = 0x00;
+  m_bg_next_tile_msb = 0x00;
+  m_bg_shifter_pattern_lo = 0x0000;
+  m_bg_shifter_pattern_hi = 0x0000;
+  m_bg_shifter_attrib_lo = 0x0000;
+  m_bg_shifter_attrib_hi = 0x0000;
+  m_oam_addr = 0x00;
+  m_sprite_count = 0;
+  m_sprite_zero_selected = false;
+  m_sprite_line.fill(0x00);
+  m_sprite_mask.fill(0);
+  m_scan_line = 0;
+  m_cycle = 0;
+  m_is_frame_complete = false;
+  m_nmi = false;
+  m_irq = false;
+  m_a12 = false;
+  update_a12_watch();
+}
+
+auto PPU::power_on() -> void {
+  for (auto &table : table_pattern) {
+    table.fill(0x00);
+  }
+  for (auto &table : table_name) {
+    table.fill(0x00);
+  }
+  table_pallette.fill(0x00);
+  m_oam.fill(0x00);
+  invalidate_debug_views();
+  reset();
+}
+
+auto PPU::set_framebuffer(uint32_t *buffer, PixelFormat format) -> void {
+  m_framebuffer = buffer != nullptr ? buffer : m_frame.data();
+  m_pixel_format = format;
+  m_colours = format == PixelFormat::BGRA ? s_colours_bgra.data()
+                                          : s_colours_rgba.data();
+}
+
+auto PPU::get_framebuffer() -> uint32_t * { return m_framebuffer; }
+
+auto PPU::get_pixel_format() const -> PixelFormat { return m_pixel_format; }
+
+auto PPU::get_bytes_per_pixel(PixelFormat format) -> size_t {
+  return format == PixelFormat::Index ? 1 : 4;
+}
+
+auto PPU::get_emphasis(int scan_line) const -> uint8_t {
+  return m_emphasis.at(scan_line);
+}
+
+auto PPU::set_pixel_output(bool is_enabled) -> void {
+  m_is_pixel_output = is_enabled;
+}
+
+auto PPU::get_pixel_output() const -> bool { return m_is_pixel_output; }
+
+auto PPU::load_palette(const std::string &fname) -> bool {
+  std::ifstream stream(fname, std::ifstream::binary);
+  if (!stream.is_open()) {
+    return false;
+  }
+
+  const std::vector<uint8_t> bytes{std::istreambuf_iterator<char>(stream),
+                                   std::istreambuf_iterator<char>()};
+  if (bytes.size() != 64 * 3 && bytes.size() != 512 * 3) {
+    return false;
+  }
+
+  for (size_t i = 0; i < s_colours_rgba.size(); i++) {
+    uint32_t rgba = 0;
+    if (bytes.size() == 512 * 3) {
+      rgba = rgb(bytes[i * 3], bytes[i * 3 + 1], bytes[i * 3 + 2]);
+    } else {
+      const size_t colour = i & 0x3f;
+      rgba = emphasise(rgb(bytes[colour * 3], bytes[colour * 3 + 1],
+                           bytes[colour * 3 + 2]),
+                       i >> 6);
+    }
+    s_colours_rgba[i] = rgba;
+    s_colours_bgra[i] = to_bgra(rgba);
+  }
+  return true;
+}
+
+auto PPU::flush_line() -> void {
+  const int offset = m_scan_line * ScreenWidth;
+
+  if (m_pixel_format == PixelFormat::Index) {
+    auto *dst = reinterpret_cast<uint8_t *>(m_framebuffer) + offset;
+    for (int x = 0; x < ScreenWidth; x++) {
+      dst[x] = m_line[x] & 0x3f;
+    }
+    return;
+  }
+
+  // a single table load per pixel, which compilers can turn into gathers
+  uint32_t *dst = m_framebuffer + offset;
+  for (int x = 0; x < ScreenWidth; x++) {
+    dst[x] = m_colours[m_line[x]];
+  }
+}
+
+auto PPU::increment_scroll_x() -> void {
+  if (!(m_mask & (MaskFlags::RenderBackground | MaskFlags::RenderSprites))) {
+    return;
+  }
+  if ((m_vram_addr & 0x001f) == 31) {
+    // wrap into the horizontally adjacent nametable
+    m_vram_addr &= ~0x001f;
+    m_vram_addr ^= 0x0400;
+  } else {
+    m_vram_addr += 1;
+  }
+}
+
+auto PPU::increment_scroll_y() -> void {
+  if (!(m_mask & (MaskFlags::RenderBackground | MaskFlags::RenderSprites))) {
+    return;
+  }
+  if ((m_vram_addr & 0x7000) != 0x7000) {
+    m_vram_addr += 0x1000;
+    return;
+  }
+
+  m_vram_addr &= ~0x7000;
+  uint16_t coarse_y = (m_vram_addr >> 5) & 0x001f;
+  if (coarse_y == 29) {
+    // rows 30 and 31 hold attributes, so wrap into the next nametable
+    coarse_y = 0;
+    m_vram_addr ^= 0x0800;
+  } else if (coarse_y == 31) {
+    coarse_y = 0;
+  } else {
+    coarse_y += 1;
+  }
+  m_vram_addr = (m_vram_addr & ~0x03e0) | (coarse_y << 5);
+}
+
+auto PPU::transfer_address_x() -> void {
+  if (m_mask & (MaskFlags::RenderBackground | MaskFlags::RenderSprites)) {
+    m_vram_addr = (m_vram_addr & ~0x041f) | (m_tram_addr & 0x041f);
+  }
+}
+
+auto PPU::transfer_address_y() -> void {
+  if (m_mask & (MaskFlags::RenderBackground | MaskFlags::RenderSprites)) {
+    m_vram_addr = (m_vram_addr & ~0x7be0) | (m_tram_addr & 0x7be0);
+  }
+}
+
+auto PPU::load_background_shifters() -> void {
+  m_bg_shifter_pattern_lo =
+      (m_bg_shifter_pattern_lo & 0xff00) | m_bg_next_tile_lsb;
+  m_bg_shifter_pattern_hi =
+      (m_bg_shifter_pattern_hi & 0xff00) | m_bg_next_tile_msb;
+
+  // the attribute applies to the whole tile, so inflate it to 8 pixels
+  m_bg_shifter_attrib_lo = (m_bg_shifter_attrib_lo & 0xff00) |
+                           ((m_bg_next_tile_attrib & 0x01) ? 0xff : 0x00);
+  m_bg_shifter_attrib_hi = (m_bg_shifter_attrib_hi & 0xff00) |
+                           ((m_bg_next_tile_attrib & 0x02) ? 0xff : 0x00);
+}
+
+auto PPU::update_shifters() -> void {
+  if (m_mask & MaskFlags::RenderBackground) {
+    m_bg_shifter_pattern_lo <<= 1;
+    m_bg_shifter_pattern_hi <<= 1;
+    m_bg_shifter_attrib_lo <<= 1;
+    m_bg_shifter_attrib_hi <<= 1;
+  }
+}
+
+auto PPU::evaluate_sprites() -> void {
+  const uint8_t height = (m_control & ControlFlags::SpriteSize) ? 16 : 8;
+  auto in_range = [this, height](uint8_t y) {
+    const int row = m_scan_line - y;
+    return row >= 0 && row < height;
+  };
+
+  m_sprite_count = 0;
+  m_sprite_zero_selected = false;
+
+  uint8_t n = 0;
+  for (; n < 64 && m_sprite_count < 8; n++) {
+    if (in_range(m_oam[n * 4])) {
+      std::memcpy(&m_sprite_scan_line[m_sprite_count], &m_oam[n * 4], 4);
+      m_sprite_count += 1;
+      m_sprite_zero_selected |= (n == 0);
+    }
+  }
+
+  // once 8 sprites are found the hardware keeps scanning for an overflow
+  // but also steps the byte offset, so it compares tile ids, attributes
+  // and x positions as if they were y coordinates
+  for (uint8_t m = 0; n < 64; n++, m = (m + 1) & 0x03) {
+    if (in_range(m_oam[n * 4 + m])) {
+      m_status |= StatusFlags::SpriteOverflow;
+      break;
+    }
+  }
+}
+
+auto PPU::render_sprite_line() -> void {
+  m_sprite_line.fill(0x00);
+  m_sprite_mask.fill(0);
+
+  // without pixel output only sprite 0 matters, for the hit flag
+  const uint8_t count =
+      m_is_pixel_output ? m_sprite_count : (m_sprite_zero_selected ? 1 : 0);
+
+  for (uint8_t i = 0; i < count; i++) {
+    const ObjectAttribute &sprite = m_sprite_scan_line[i];
+    uint8_t row = m_scan_line - sprite.y;
+    uint16_t address = 0x0000;
+
+    if (m_control & ControlFlags::SpriteSize) {
+      // 8x16: bit 0 of the id selects the table, each half is its own tile
+      if (sprite.attribute & SpriteFlags::FlipVertical) {
+        row = 15 - row;
+      }
+      address = ((sprite.id & 0x01) << 12) | ((sprite.id & 0xfe) << 4) |
+                ((row & 0x08) << 1) | (row & 0x07);
+    } else {
+      if (sprite.attribute & SpriteFlags::FlipVertical) {
+        row = 7 - row;
+      }
+      address = ((m_control & ControlFlags::PatternSprite) << 9) |
+                (sprite.id << 4) | row;
+    }
+
+    uint8_t lsb = read_ppu(address);
+    uint8_t msb = read_ppu(address + 8);
+
+    const uint8_t flags =
+        ((sprite.attribute & SpriteFlags::Palette) << 2) |
+        (sprite.attribute & SpriteFlags::BehindBackground) |
+        ((i == 0 && m_sprite_zero_selected) ? LineFlags::SpriteZero : 0x00);
+    const bool flip = sprite.attribute & SpriteFlags::FlipHorizontal;
+
+    for (uint8_t col = 0; col < 8; col++) {
+      const uint8_t bit = flip ? col : 7 - col;
+      const uint8_t pixel =
+          (((msb >> bit) & 0x01) << 1) | ((lsb >> bit) & 0x01);
+      const int x = sprite.x + col;
+
+      // lower OAM indices win, even if they end up behind the background
+      if (pixel == 0 || x > 255 || m_sprite_line[x] != 0) {
+        continue;
+      }
+      if (x < 8 && !(m_mask & MaskFlags::RenderSpritesLeft)) {
+        continue;
+      }
+      m_sprite_line[x] = flags | pixel;
+      m_sprite_mask[x >> 6] |= uint64_t(1) << (x & 63);
+    }
+  }
+
+  if (!(m_mask & MaskFlags::RenderSprites)) {
+    m_sprite_mask.fill(0);
+  }
+}
+
+auto PPU::clock() -> void {
+  if (m_scan_line >= -1 && m_scan_line < 240) {
+    if (m_scan_line == -1 && m_cycle == 1) {
+      m_status &= ~(StatusFlags::VerticalBlank | StatusFlags::SpriteZeroHit |
+                    StatusFlags::SpriteOverflow);
+    }
+
+    if ((m_cycle >= 2 && m_cycle < 258) || (m_cycle >= 321 && m_cycle < 338)) {
+      update_shifters();
+
+      switch ((m_cycle - 1) % 8) {
+      case 0:
+        load_background_shifters();
+        m_bg_next_tile_id = read_name(m_vram_addr);
+        break;
+      case 2:
+        m_bg_next_tile_attrib =
+            read_name(0x03c0 | (m_vram_addr & 0x0c00) |
+                      ((m_vram_addr >> 4) & 0x38) |
+                      ((m_vram_addr >> 2) & 0x07));
+        // select the 2x2 tile quadrant within the attribute byte
+        if (m_vram_addr & 0x0040) {
+          m_bg_next_tile_attrib >>= 4;
+        }
+        if (m_vram_addr & 0x0002) {
+          m_bg_next_tile_attrib >>= 2;
+        }
+        m_bg_next_tile_attrib &= 0x03;
+        break;
+      case 4:
+        m_bg_next_tile_lsb =
+            read_ppu(((m_control & ControlFlags::PatternBackground) << 8) +
+                     (uint16_t(m_bg_next_tile_id) << 4) +
+                     ((m_vram_addr >> 12) & 0x07));
+        break;
+      case 6:
+        m_bg_next_tile_msb =
+            read_ppu(((m_control & ControlFlags::PatternBackground) << 8) +
+                     (uint16_t(m_bg_next_tile_id) << 4) +
+                     ((m_vram_addr >> 12) & 0x07) + 8);
+        break;
+      case 7:
+        increment_scroll_x();
+        break;
+      }
+    }
+
+    if (m_cycle == 256) {
+      increment_scroll_y();
+    }
+
+    if (m_cycle == 257) {
+      load_background_shifters();
+      transfer_address_x();
+
+      // selects and pre-renders the sprites of the next scanline; there is
+      // no evaluation on the pre-render line, so scanline 0 has no sprites
+      if (m_mask & (MaskFlags::RenderBackground | MaskFlags::RenderSprites)) {
+        m_oam_addr = 0x00;
+      }
+      if (m_scan_line >= 0 && (m_mask & (MaskFlags::RenderBackground |
+                                         MaskFlags::RenderSprites))) {
+        evaluate_sprites();
+      } else {
+        m_sprite_count = 0;
+        m_sprite_zero_selected = false;
+      }
+      render_sprite_line();
+
+      // empty slots fetch tile $ff
+      if (m_is_a12_per_fetch) {
+        m_sprite_a12 = 0x00;
+        for (uint8_t i = 0; i < 8; i++) {
+          const uint8_t id = i < m_sprite_count ? m_sprite_scan_line[i].id
+                                                : 0xff;
+          const bool is_high = (m_control & ControlFlags::SpriteSize)
+                                   ? (id & 0x01)
+                                   : (m_control & ControlFlags::PatternSprite);
+          m_sprite_a12 |= (is_high ? 1 : 0) << i;
+        }
+      }
+    }
+
+    if (m_cycle == m_a12_rise_dot) {
+      notify_a12_rise();
+      // it drops again before anything else looks at it
+      m_a12 = false;
+      m_a12_fall_at = get_dot_position();
+    } else if (m_is_a12_per_fetch) {
+      follow_a12_fetch();
+    }
+
+    // unused nametable fetches at the end of the scanline
+    if (m_cycle == 338 || m_cycle == 340) {
+      m_bg_next_tile_id = read_name(m_vram_addr);
+    }
+
+    if (m_scan_line == -1 && m_cycle >= 280 && m_cycle < 305) {
+      transfer_address_y();
+    }
+  }
+
+  if (m_scan_line == 241 && m_cycle == 1) {
+    m_status |= StatusFlags::VerticalBlank;
+    if (m_control & ControlFlags::EnableNmi) {
+      m_nmi = true;
+    }
+  }
+
+  if (m_scan_line >= 0 && m_scan_line < 240 && m_cycle >= 1 &&
+      m_cycle <= 256) {
+    const int x = m_cycle - 1;
+    uint8_t bg_pixel = 0x00;
+    uint8_t bg_palette = 0x00;
+
+    if ((m_mask & MaskFlags::RenderBackground) &&
+        (x >= 8 || (m_mask & MaskFlags::RenderBackgroundLeft))) {
+      const uint16_t bit_mux = 0x8000 >> m_fine_x;
+
+      bg_pixel = ((m_bg_shifter_pattern_hi & bit_mux) ? 0x02 : 0x00) |
+                 ((m_bg_shifter_pattern_lo & bit_mux) ? 0x01 : 0x00);
+      bg_palette = ((m_bg_shifter_attrib_hi & bit_mux) ? 0x02 : 0x00) |
+                   ((m_bg_shifter_attrib_lo & bit_mux) ? 0x01 : 0x00);
+    }
+
+    uint8_t pixel = bg_pixel;
+    uint8_t palette = bg_palette;
+
+    // only x positions covered by an opaque sprite pixel need compositing
+    if ((m_sprite_mask[x >> 6] >> (x & 63)) & 0x01) {
+      const uint8_t fg = m_sprite_line[x];
+      const uint8_t fg_pixel = fg & LineFlags::Pixel;
+
+      if (bg_pixel == 0 || !(fg & LineFlags::BehindBackground)) {
+        pixel = fg_pixel;
+        palette = 0x04 | ((fg & LineFlags::Palette) >> 2);
+      }
+
+      if (bg_pixel != 0 && (fg & LineFlags::SpriteZero) && x != 255) {
+        m_status |= StatusFlags::SpriteZeroHit;
+      }
+    }
+
+    if (m_is_pixel_output) {
+      if (m_cycle == 1) {
+        m_emphasis[m_scan_line] = m_mask >> MaskFlags::EmphasisShift;
+      }
+
+      uint8_t colour = read_ppu(0x3f00 + (palette << 2) + pixel) & 0x3f;
+      if (m_mask & MaskFlags::Grayscale) {
+        colour &= 0x30;
+      }
+      m_line[x] = ((m_mask >> MaskFlags::EmphasisShift) << 6) | colour;
+
+      if (x == ScreenWidth - 1) {
+        flush_line();
+      }
+    }
+  }
+
+  m_cycle++;
+
+  // odd frames drop the last dot of the pre-render line while rendering
+  if (m_scan_line == -1 && m_cycle == 340 && m_odd_frame &&
+      (m_mask & (MaskFlags::RenderBackground | MaskFlags::RenderSprites))) {
+    m_cycle = 341;
+  }
+
+  if (m_cycle >= 341) {
+    m_cycle = 0;
+    m_scan_line += 1;
+
+    if (m_scan_line >= 261) {
+      m_scan_line = -1;
+      m_odd_frame = !m_odd_frame;
+      m_is_frame_complete = true;
+    }
+  }
+}
+
+auto PPU::update_a12_watch() -> void {
+  m_is_watching_a12 = m_cartridge && m_cartridge->is_watching_a12();
+  m_a12_rise_dot = -1;
+  m_is_a12_per_fetch = false;
+  if (!m_is_watching_a12 ||
+      !(m_mask & (MaskFlags::RenderBackground | MaskFlags::RenderSprites))) {
+    return;
+  }
+
+  const bool is_background_high = m_control & ControlFlags::PatternBackground;
+  const bool is_sprite_high = m_control & ControlFlags::PatternSprite;
+  if ((m_control & ControlFlags::SpriteSize) ||
+      (is_background_high && is_sprite_high)) {
+    // 8x16 sprites pick a table each, and with both on $1000 A12 is never
+    // low for long
+    m_is_a12_per_fetch = true;
+  } else if (is_sprite_high) {
+    // the first sprite pattern fetch
+    m_a12_rise_dot = 261;
+  } else if (is_background_high) {
+    // the first background fetch after the sprites
+    m_a12_rise_dot = 325;
+  }
+}
+
+// the pattern fetches of the line as the hardware makes them: tiles of
+// eight dots, two nametable or attribute reads then two pattern reads
+auto PPU::follow_a12_fetch() -> void {
+  if (m_cycle == 0 || m_cycle > 336) {
+    if (m_cycle == 337) {
+      track_a12(false);
+    }
+    return;
+  }
+
+  if (m_cycle >= 257 && m_cycle <= 320) {
+    const int slot = (m_cycle - 257) >> 3;
+    switch ((m_cycle - 257) & 0x07) {
+    case 0:
+      track_a12(false);
+      break;
+    case 4:
+      track_a12((m_sprite_a12 >> slot) & 0x01);
+      break;
+    }
+    return;
+  }
+
+  switch ((m_cycle - 1) & 0x07) {
+  case 0:
+    track_a12(false);
+    break;
+  case 4:
+    track_a12(m_control & ControlFlags::PatternBackground);
+    break;
+  }
+}
+
+auto PPU::track_a12(bool is_high) -> void {
+  if (is_high && !m_a12) {
+    const int32_t low_for =
+        (get_dot_position() - m_a12_fall_at + frame_dots) % frame_dots;
+    if (low_for > a12_filter_dots) {
+      notify_a12_rise();
+    }
+  } else if (!is_high && m_a12) {
+    m_a12_fall_at = get_dot_position();
+  }
+  m_a12 = is_high;
+}
+
+auto PPU::notify_a12_rise() -> void {
+  m_cartridge->notify_a12_rise();
+  // handed to the bus on this dot, the way NMI is
+  if (m_cartridge->is_irq_asserted()) {
+    m_irq = true;
+  }
+}
+
+auto PPU::get_dot_position() const -> int32_t {
+  return (m_scan_line + 1) * 341 + m_cycle;
+}
+
+auto PPU::invalidate_debug_views() -> void {
+  for (auto &dirty : m_pattern_dirty) {
+    dirty.set();
+  }
+  for (auto &dirty : m_name_dirty) {
+    dirty.set();
+  }
+}
+
+auto PPU::collect_changed_tiles(
+    uint16_t table, std::array<Cartridge::TileVersion, 256> &versions,
+    std::bitset<256> &changed) -> void {
+  if (!m_cartridge) {
+    return;
+  }
+  for (uint16_t tile = 0; tile < 256; tile++) {
+    const auto version = m_cartridge->get_tile_version(table + tile * 16);
+    if (version != versions[tile]) {
+      versions[tile] = version;
+      changed.set(tile);
+    }
+  }
+}
+
+auto PPU::mark_name_dirty(uint8_t table, uint16_t offset) -> void {
+  if (offset < 960) {
+    m_name_dirty[table].set(offset);
+    return;
+  }
+
+  // an attribute byte colours a 4x4 block of tiles
+  const uint16_t block = offset - 960;
+  const uint16_t top = (block >> 3) * 4;
+  const uint16_t left = (block & 0x07) * 4;
+  for (uint16_t y = top; y < top + 4 && y < 30; y++) {
+    for (uint16_t x = left; x < left + 4; x++) {
+      m_name_dirty[table].set(y * 32 + x);
+    }
+  }
+}
+
+auto PPU::mark_palette_dirty(uint8_t address) -> void {
+  // a pattern view reads the four entries of its palette, the backdrop of a
+  // sprite palette being the background one it mirrors
+  for (uint8_t i = 0; i < 2; i++) {
+    for (uint8_t pixel = 0; pixel < 4; pixel++) {
+      uint8_t entry = (m_pattern_view_palette[i] << 2) + pixel;
+      if ((entry & 0x13) == 0x10) {
+        entry &= 0x0f;
+      }
+      if (entry == address) {
+        m_pattern_dirty[i].set();
+        break;
+      }
+    }
+  }
+
+  // the nametable views only use the background palettes
+  if (address >= 0x10) {
+    return;
+  }
+  for (uint8_t i = 0; i < 2; i++) {
+    for (uint16_t entry = 0; entry < 960; entry++) {
+      if (get_name_palette(i, entry) == address >> 2) {
+        m_name_dirty[i].set(entry);
+      }
+    }
+  }
+}
+
+auto PPU::get_name_palette(uint8_t i, uint16_t entry) const -> uint8_t {
+  const int x = entry & 0x1f;
+  const int y = entry >> 5;
+  const uint8_t attrib = table_name[i][960 + (y >> 2) * 8 + (x >> 2)];
+  return (attrib >> (((y & 0x02) << 1) | (x & 0x02))) & 0x03;
+}
+
+auto PPU::draw_pattern_tile(uint8_t i, uint8_t tile, uint8_t palette)
+    -> void {
+  auto *pixels =
+      reinterpret_cast<uint32_t *>(m_spr_table_pattern[i].GetData());
+  const uint16_t base = i * 0x1000 + tile * 16;
+  const int left = (tile & 0x0f) * 8;
+  const int top = (tile >> 4) * 8;
+
+  for (int row = 0; row < 8; row++) {
+    uint8_t lsb = read_ppu(base + row);
+    uint8_t msb = read_ppu(base + row + 8);
+    uint32_t *dst = pixels + (top + row) * 128 + left;
+    for (int col = 7; col >= 0; col--) {
+      const uint8_t pixel = ((msb & 0x01) << 1) | (lsb & 0x01);
+      lsb >>= 1;
+      msb >>= 1;
+      dst[col] =
+          s_colours_rgba[read_ppu(0x3f00 + (palette << 2) + pixel) & 0x3f];
+    }
+  }
+}
+
+auto PPU::draw_name_entry(uint8_t i, uint16_t entry) -> void {
+  auto *pixels = reinterpret_cast<uint32_t *>(m_spr_table_name[i].GetData());
+  const int x = entry & 0x1f;
+  const int y = entry >> 5;
+
+  const uint8_t palette = get_name_palette(i, entry);
+  const uint16_t base = ((m_control & ControlFlags::PatternBackground) << 8) +
+                        table_name[i][entry] * 16;
+
+  for (int row = 0; row < 8; row++) {
+    uint8_t lsb = read_ppu(base + row);
+    uint8_t msb = read_ppu(base + row + 8);
+    uint32_t *dst = pixels + (y * 8 + row) * 256 + x * 8;
+    for (int col = 7; col >= 0; col--) {
+      const uint8_t pixel = ((msb & 0x01) << 1) | (lsb & 0x01);
+      lsb >>= 1;
+      msb >>= 1;
+      dst[col] =
+          s_colours_rgba[read_ppu(0x3f00 + (palette << 2) + pixel) & 0x3f];
+    }
+  }
+}
+
+auto PPU::get_table_name(uint8_t i) -> olc::Sprite & {
+  auto &dirty = m_name_dirty.at(i);
+
+  // entries whose pattern changed are stale as well
+  std::bitset<256> changed;
+  collect_changed_tiles((m_control & ControlFlags::PatternBackground) << 8,
+                        m_name_versions[i], changed);
+  if (changed.any()) {
+    for (uint16_t entry = 0; entry < 960; entry++) {
+      if (changed.test(table_name[i][entry])) {
+        dirty.set(entry);
+      }
+    }
+  }
+
+  if (dirty.any()) {
+    for (uint16_t entry = 0; entry < 960; entry++) {
+      if (dirty.test(entry)) {
+        draw_name_entry(i, entry);
+      }
+    }
+    dirty.reset();
+  }
+
+  return m_spr_table_name[i];
+}
+
+auto PPU::get_table_pattern(uint8_t i, uint8_t palette) -> olc::Sprite & {
+  auto &dirty = m_pattern_dirty.at(i);
+
+  if (m_pattern_view_palette[i] != palette) {
+    m_pattern_view_palette[i] = palette;
+    dirty.set();
+  }
+  collect_changed_tiles(i * 0x1000, m_pattern_versions.at(i), dirty);
+
+  if (dirty.any()) {
+    for (uint16_t tile = 0; tile < 256; tile++) {
+      if (dirty.test(tile)) {
+        draw_pattern_tile(i, tile, palette);
+      }
+    }
+    dirty.reset();
+  }
+
+  return m_spr_table_pattern[i];
 }
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include "../include/Rewind.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+// copies the worker may fall behind by before push waits for it
+constexpr size_t max_pending = 8;
+
+auto bytes_of(SaveState &state) -> uint8_t * {
+  return reinterpret_cast<uint8_t *>(&state);
+}
+
+auto bytes_of(const SaveState &state) -> const uint8_t * {
+  return reinterpret_cast<const uint8_t *>(&state);
+}
+
+auto write_varint(std::vector<uint8_t> &out, size_t value) -> void {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+auto read_varint(const std::vector<uint8_t> &in, size_t &i) -> size_t {
+  size_t value = 0;
+  for (int shift = 0; i < in.size(); shift += 7) {
+    const uint8_t byte = in[i++];
+    value |= size_t(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      break;
+    }
+  }
+  return value;
+}
+} // namespace
+
+RewindBuffer::RewindBuffer(size_t budget, uint32_t keyframe_interval)
+    : m_budget(budget), m_keyframe_interval(std::max(keyframe_interval, 1u)),
+      m_keyframe(std::make_unique<SaveState>()),
+      m_scratch(std::make_unique<SaveState>()),
+      m_worker(&RewindBuffer::work, this) {}
+
+RewindBuffer::~RewindBuffer() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+  }
+  m_wake.notify_one();
+  m_worker.join();
+}
+
+auto RewindBuffer::push(const SaveState &state) -> void {
+  std::unique_ptr<SaveState> copy;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_spare.empty()) {
+      copy = std::move(m_spare.back());
+      m_spare.pop_back();
+    }
+  }
+
+  if (copy) {
+    *copy = state;
+  } else {
+    copy = std::make_unique<SaveState>(state);
+  }
+
+  {
+    // every frame is kept, so a slow worker holds the emulation back
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_room.wait(lock, [this]() { return m_pending.size() < max_pending; });
+    m_pending.push_back(std::move(copy));
+  }
+  m_wake.notify_one();
+}
+
+auto RewindBuffer::pop(SaveState &state) -> bool {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_idle.wait(lock, [this]() { return m_pending.empty() && !m_is_busy; });
+
+  if (m_groups.empty()) {
+    return false;
+  }
+
+  Group &group = m_groups.back();
+  std::fill_n(bytes_of(state), sizeof(SaveState), uint8_t(0));
+  unpack(group.keyframe, bytes_of(state), sizeof(SaveState));
+
+  if (!group.deltas.empty()) {
+    unpack(group.deltas.back(), bytes_of(state), sizeof(SaveState));
+    const size_t bytes = group.deltas.back().size();
+    group.bytes -= bytes;
+    m_memory_used -= bytes;
+    group.deltas.pop_back();
+  } else {
+    // the worker's keyframe went with the group, start a new one
+    m_memory_used -= group.bytes;
+    m_groups.pop_back();
+    m_has_keyframe = false;
+  }
+
+  m_frames -= 1;
+  return true;
+}
+
+auto RewindBuffer::clear() -> void {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (auto &pending : m_pending) {
+    m_spare.push_back(std::move(pending));
+  }
+  m_pending.clear();
+  m_room.notify_all();
+  m_idle.wait(lock, [this]() { return !m_is_busy; });
+
+  m_groups.clear();
+  m_frames = 0;
+  m_memory_used = 0;
+  m_has_keyframe = false;
+}
+
+auto RewindBuffer::get_frame_count() const -> size_t {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_frames;
+}
+
+auto RewindBuffer::get_memory_used() const -> size_t {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_memory_used;
+}
+
+auto RewindBuffer::work() -> void {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_wake.wait(lock, [this]() { return m_quit || !m_pending.empty(); });
+    if (m_quit) {
+      return;
+    }
+
+    auto state = std::move(m_pending.front());
+    m_pending.pop_front();
+    m_is_busy = true;
+    m_room.notify_one();
+
+    lock.unlock();
+    store(*state);
+    lock.lock();
+
+    m_spare.push_back(std::move(state));
+    m_is_busy = false;
+    if (m_pending.empty()) {
+      m_idle.notify_all();
+    }
+  }
+}
+
+auto RewindBuffer::store(const SaveState &state) -> void {
+  bool is_keyframe;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    is_keyframe = !m_has_keyframe || m_groups.empty() ||
+                  m_groups.back().deltas.size() + 1 >= m_keyframe_interval;
+  }
+
+  // packing runs unlocked; pop and clear only touch the keyframe while the
+  // worker is idle
+  if (is_keyframe) {
+    *m_keyframe = state;
+    pack(bytes_of(state), sizeof(SaveState), m_packed);
+  } else {
+    const uint8_t *key = bytes_of(*m_keyframe);
+    const uint8_t *now = bytes_of(state);
+    uint8_t *delta = bytes_of(*m_scratch);
+    for (size_t i = 0; i < sizeof(SaveState); i++) {
+      delta[i] = key[i] ^ now[i];
+    }
+    pack(delta, sizeof(SaveState), m_packed);
+  }
+
+  std::vector<uint8_t> packed(m_packed.begin(), m_packed.end());
+  const size_t bytes = packed.size();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (is_keyframe) {
+    m_groups.emplace_back();
+    m_groups.back().keyframe = std::move(packed);
+    m_has_keyframe = true;
+  } else {
+    m_groups.back().deltas.push_back(std::move(packed));
+  }
+  m_groups.back().bytes += bytes;
+  m_memory_used += bytes;
+  m_frames += 1;
+
+  // deltas are useless without their keyframe, so whole groups go at once
+  while (m_memory_used > m_budget && m_groups.size() > 1) {
+    m_memory_used -= m_groups.front().bytes;
+    m_frames -= 1 + m_groups.front().deltas.size();
+    m_groups.pop_front();
+  }
+}
+
+// alternating runs of zeros and literal bytes, each prefixed by its length;
+// isolated zeros stay inside a literal rather than splitting it
+auto RewindBuffer::pack(const uint8_t *src, size_t size,
+                        std::vector<uint8_t> &out) -> void {
+  out.clear();
+
+  size_t i = 0;
+  while (i < size) {
+    const size_t zeros_start = i;
+    while (i < size && src[i] == 0) {
+      i++;
+    }
+
+    const size_t literal_start = i;
+    while (i < size && !(src[i] == 0 && i + 2 < size && src[i + 1] == 0 &&
+                         src[i + 2] == 0)) {
+      i++;
+    }
+
+    write_varint(out, literal_start - zeros_start);
+    write_varint(out, i - literal_start);
+    out.insert(out.end(), src + literal_start, src + i);
+  }
+}
+
+// XORs the literals into dst, zero runs leave it as it is
+auto RewindBuffer::unpack(const std::vector<uint8_t> &src, uint8_t *dst,
+                          size_t size) -> void {
+  size_t i = 0;
+  size_t pos = 0;
+  while (i < src.size()) {
+    pos += read_varint(src, i);
+    const size_t literal = read_varint(src, i);
+    if (pos + literal > size || i + literal > src.size()) {
+      return;
+    }
+    for (size_t k = 0; k < literal; k++) {
+      dst[pos++] ^= src[i++];
+    }
+  }
+}
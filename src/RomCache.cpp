@@ -0,0 +1,342 @@
+#include "../include/RomCache.hpp"
+#include "../include/Checksum.hpp"
+#include "../include/Inflate.hpp"
+#include "../include/RomDatabase.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::mutex RomCache::s_mutex;
+std::shared_ptr<const RomDatabase> RomCache::s_database;
+std::unordered_map<std::string, std::weak_ptr<const RomImage>>
+    RomCache::s_images;
+
+namespace {
+auto get_le16(const uint8_t *data) -> uint16_t {
+  return data[0] | (data[1] << 8);
+}
+
+auto get_le32(const uint8_t *data) -> uint32_t {
+  return data[0] | (data[1] << 8) | (data[2] << 16) |
+         (uint32_t(data[3]) << 24);
+}
+
+auto is_gzip(const uint8_t *magic) -> bool {
+  return magic[0] == 0x1f && magic[1] == 0x8b;
+}
+
+auto is_zip(const uint8_t *magic) -> bool {
+  return std::memcmp(magic, "PK\x03\x04", 4) == 0;
+}
+
+auto is_rom_name(const std::string &name) -> bool {
+  return name.size() >= 4 &&
+         std::equal(name.end() - 4, name.end(), ".nes", [](char a, char b) {
+           return std::tolower(static_cast<unsigned char>(a)) == b;
+         });
+}
+
+// RFC 1952, past the magic; only the first member is read
+auto unpack_gzip(Inflate &input, const uint8_t *magic, size_t expected_size,
+                 std::vector<uint8_t> &rom) -> bool {
+  static constexpr uint8_t has_crc = 0x02, has_extra = 0x04,
+                           has_name = 0x08, has_comment = 0x10;
+
+  const uint8_t flags = magic[3];
+  uint8_t field[2];
+  if (magic[2] != 8 || !input.skip_bytes(6)) {
+    return false;
+  }
+  if ((flags & has_extra) &&
+      (!input.read_bytes(field, 2) || !input.skip_bytes(get_le16(field)))) {
+    return false;
+  }
+  for (const uint8_t text : {has_name, has_comment}) {
+    if (flags & text) {
+      do {
+        if (!input.read_bytes(field, 1)) {
+          return false;
+        }
+      } while (field[0] != 0);
+    }
+  }
+  if ((flags & has_crc) && !input.skip_bytes(2)) {
+    return false;
+  }
+
+  uint8_t trailer[8];
+  return input.inflate(rom, expected_size) &&
+         input.read_bytes(trailer, sizeof(trailer)) &&
+         Checksum::crc32(rom.data(), rom.size()) == get_le32(trailer) &&
+         static_cast<uint32_t>(rom.size()) == get_le32(trailer + 4);
+}
+
+// walks the local headers past the first signature, so archives are read
+// front to back like a stream; entries before the ROM are decoded and
+// dropped rather than skipped, their sizes may only follow their data
+auto unpack_zip(Inflate &input, std::vector<uint8_t> &rom) -> bool {
+  static constexpr uint16_t is_encrypted = 0x0001, has_descriptor = 0x0008;
+  static constexpr uint16_t stored = 0, deflated = 8;
+
+  uint8_t signature[4];
+  do {
+    uint8_t header[26];
+    if (!input.read_bytes(header, sizeof(header))) {
+      return false;
+    }
+    const uint16_t flags = get_le16(header + 2);
+    const uint16_t method = get_le16(header + 4);
+    uint32_t crc = get_le32(header + 10);
+    const uint32_t compressed_size = get_le32(header + 14);
+    const uint32_t size = get_le32(header + 18);
+
+    std::string name(get_le16(header + 22), '\0');
+    if (!input.read_bytes(reinterpret_cast<uint8_t *>(&name[0]),
+                          name.size()) ||
+        !input.skip_bytes(get_le16(header + 24)) || (flags & is_encrypted)) {
+      return false;
+    }
+
+    std::vector<uint8_t> data;
+    if (method == deflated) {
+      if (!input.inflate(data, (flags & has_descriptor) ? 0 : size)) {
+        return false;
+      }
+    } else if (method == stored && !(flags & has_descriptor) &&
+               compressed_size <= Inflate::MaxOutput) {
+      data.resize(compressed_size);
+      if (!input.read_bytes(data.data(), data.size())) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+
+    // the descriptor signature is optional
+    if (flags & has_descriptor) {
+      uint8_t descriptor[16];
+      if (!input.read_bytes(descriptor, 12)) {
+        return false;
+      }
+      const bool is_signed = std::memcmp(descriptor, "PK\x07\x08", 4) == 0;
+      if (is_signed && !input.read_bytes(descriptor + 12, 4)) {
+        return false;
+      }
+      crc = get_le32(descriptor + (is_signed ? 4 : 0));
+    }
+    if (Checksum::crc32(data.data(), data.size()) != crc) {
+      return false;
+    }
+
+    if (is_rom_name(name) ||
+        (data.size() >= 4 && std::memcmp(data.data(), "NES\x1a", 4) == 0)) {
+      rom = std::move(data);
+      return true;
+    }
+  } while (input.read_bytes(signature, sizeof(signature)) &&
+           is_zip(signature));
+
+  // the central directory, the archive holds no ROM
+  return false;
+}
+
+// reads a plain, gzipped or zipped ROM file from input
+auto unpack(Inflate &input, size_t expected_size, std::vector<uint8_t> &rom)
+    -> bool {
+  uint8_t magic[4];
+  if (!input.read_bytes(magic, sizeof(magic))) {
+    return false;
+  }
+  if (is_gzip(magic)) {
+    return unpack_gzip(input, magic, expected_size, rom);
+  }
+  if (is_zip(magic)) {
+    return unpack_zip(input, rom);
+  }
+  rom.assign(magic, magic + sizeof(magic));
+  return input.read_rest(rom);
+}
+
+auto from_unpacked(std::shared_ptr<std::vector<uint8_t>> rom)
+    -> std::shared_ptr<RomImage> {
+  const uint8_t *data = rom->data();
+  const size_t size = rom->size();
+  return RomImage::from_memory(data, size, std::move(rom));
+}
+} // namespace
+
+auto RomImage::from_memory(const uint8_t *data, size_t size,
+                           std::shared_ptr<const void> storage)
+    -> std::shared_ptr<RomImage> {
+  RomHeader header{};
+  if (size < sizeof(RomHeader)) {
+    return nullptr;
+  }
+  std::memcpy(&header, data, sizeof(RomHeader));
+
+  auto image = std::make_shared<RomImage>();
+  RomDescriptor &descriptor = image->descriptor;
+  if (!RomDescriptor::parse(header, descriptor) ||
+      descriptor.get_file_size() > size) {
+    return nullptr;
+  }
+
+  // the trainer is skipped, nothing uses it
+  const size_t offset = sizeof(RomHeader) + (descriptor.has_trainer ? 512 : 0);
+  image->prg_rom = data + offset;
+  if (descriptor.chr_rom_size > 0) {
+    image->chr_rom = data + offset + descriptor.prg_rom_size;
+  }
+  image->storage = std::move(storage);
+  return image;
+}
+
+auto RomImage::from_bytes(const uint8_t *data, size_t size)
+    -> std::shared_ptr<RomImage> {
+  // gzip ends in the decoded size, so the ROM is allocated once
+  const size_t expected_size =
+      size >= 18 && is_gzip(data) ? get_le32(data + size - 4) : 0;
+
+  auto rom = std::make_shared<std::vector<uint8_t>>();
+  Inflate input(data, size);
+  if (!unpack(input, expected_size, *rom)) {
+    return nullptr;
+  }
+  return from_unpacked(std::move(rom));
+}
+
+auto RomImage::from_stream(std::istream &stream) -> std::shared_ptr<RomImage> {
+  auto rom = std::make_shared<std::vector<uint8_t>>();
+  Inflate input([&stream](uint8_t *buffer, size_t size) -> size_t {
+    stream.read(reinterpret_cast<char *>(buffer),
+                static_cast<std::streamsize>(size));
+    return static_cast<size_t>(stream.gcount());
+  });
+  if (!unpack(input, 0, *rom)) {
+    return nullptr;
+  }
+  return from_unpacked(std::move(rom));
+}
+
+auto RomImage::from_file(const std::string &fname)
+    -> std::shared_ptr<RomImage> {
+  const int fd = ::open(fname.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat info {};
+  if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) ||
+      info.st_size < static_cast<off_t>(sizeof(RomHeader))) {
+    ::close(fd);
+    return nullptr;
+  }
+
+  // the mapping stays valid once the descriptor is closed
+  const auto size = static_cast<size_t>(info.st_size);
+  void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+
+  std::shared_ptr<const void> storage(
+      data, [size](const void *mapping) {
+        ::munmap(const_cast<void *>(mapping), size);
+      });
+
+  // compressed files only need the mapping until they are inflated
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  if (is_gzip(bytes) || is_zip(bytes)) {
+    return RomImage::from_bytes(bytes, size);
+  }
+  return RomImage::from_memory(bytes, size, std::move(storage));
+}
+
+auto RomImage::get_crc32() const -> uint32_t {
+  // CHR-ROM follows PRG-ROM directly in the file
+  return Checksum::crc32(prg_rom, descriptor.prg_rom_size +
+                                      descriptor.chr_rom_size);
+}
+
+auto RomCache::get(const std::string &fname)
+    -> std::shared_ptr<const RomImage> {
+  // different spellings of the same path share one entry
+  std::error_code error;
+  const auto path = std::filesystem::weakly_canonical(fname, error);
+  const std::string key = error ? fname : path.string();
+
+  {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    const auto found = s_images.find(key);
+    if (found != s_images.end()) {
+      if (auto image = found->second.lock()) {
+        return image;
+      }
+    }
+    // a miss is rare enough to sweep out the images nobody holds any more
+    for (auto it = s_images.begin(); it != s_images.end();) {
+      it = it->second.expired() ? s_images.erase(it) : std::next(it);
+    }
+  }
+
+  // reading and inflating a file takes a while, other ROMs are served
+  // meanwhile
+  auto image = RomImage::from_file(fname);
+  if (!image) {
+    return nullptr;
+  }
+  const uint32_t crc32 = image->get_crc32();
+
+  std::lock_guard<std::mutex> lock(s_mutex);
+  // another thread may have loaded the same file, its image is the one shared
+  if (auto loaded = s_images[key].lock()) {
+    return loaded;
+  }
+  if (s_database) {
+    s_database->correct(crc32, image->descriptor);
+  }
+  s_images[key] = image;
+  return image;
+}
+
+auto RomCache::load(const uint8_t *data, size_t size)
+    -> std::shared_ptr<const RomImage> {
+  return correct(RomImage::from_bytes(data, size));
+}
+
+auto RomCache::load(std::istream &stream) -> std::shared_ptr<const RomImage> {
+  return correct(RomImage::from_stream(stream));
+}
+
+auto RomCache::correct(const std::shared_ptr<RomImage> &image)
+    -> std::shared_ptr<const RomImage> {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  if (image && s_database) {
+    s_database->correct(image->get_crc32(), image->descriptor);
+  }
+  return image;
+}
+
+auto RomCache::set_database(std::shared_ptr<const RomDatabase> database)
+    -> void {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  s_database = std::move(database);
+}
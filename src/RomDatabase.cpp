@@ -0,0 +1,409 @@
+#include "../include/RomDatabase.hpp"
+#include "../include/RomCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace {
+namespace fs = std::filesystem;
+
+// the file: this header, the records, then every path back to back
+struct IndexHeader {
+  static constexpr std::array<uint8_t, 4> Magic{'N', 'I', 'D', 'X'};
+  static constexpr uint32_t Version = 1;
+
+  std::array<uint8_t, 4> magic;
+  uint32_t version;
+  uint32_t entries;
+  uint32_t paths_size;
+};
+
+struct IndexRecord {
+  int64_t mtime;
+  uint64_t file_size;
+  uint32_t crc32;
+  uint32_t path_offset;
+  uint32_t prg_rom_size;
+  uint32_t chr_rom_size;
+  Checksum::Sha1Digest sha1;
+  uint16_t mapper_id;
+  uint16_t path_size;
+  uint8_t submapper;
+  uint8_t format;
+  uint8_t flags; // vertical, four-screen, battery, trainer from bit 0 up
+  uint8_t timing;
+  // RAM sizes as NES 2.0 shift counts: 64 << shift bytes, 0 for none
+  std::array<uint8_t, 4> ram_shifts;
+  uint8_t fixes;
+  std::array<uint8_t, 7> reserved;
+};
+
+static_assert(sizeof(IndexRecord) == 72, "records have no padding");
+static_assert(std::is_trivially_copyable<IndexRecord>::value,
+              "records are written as they are in memory");
+
+auto to_shift(uint64_t size) -> uint8_t {
+  uint8_t shift = 0;
+  while (size != 0 && (uint64_t(64) << shift) < size && shift < 15) {
+    shift++;
+  }
+  return size == 0 ? 0 : shift;
+}
+
+auto from_shift(uint8_t shift) -> uint64_t {
+  return shift ? uint64_t(64) << shift : 0;
+}
+
+// how far a header can be trusted
+auto get_rank(RomDescriptor::Format format) -> int {
+  switch (format) {
+  case RomDescriptor::Format::Nes20:
+    return 2;
+  case RomDescriptor::Format::INes:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+auto get_fixes(const RomDescriptor &have, const RomDescriptor &best)
+    -> uint8_t {
+  uint8_t fixes = 0;
+  if (have.mapper_id != best.mapper_id) {
+    fixes |= RomDatabase::Mapper;
+  }
+  if (have.submapper != best.submapper) {
+    fixes |= RomDatabase::Submapper;
+  }
+  if (have.is_vertical_mirroring != best.is_vertical_mirroring ||
+      have.is_four_screen != best.is_four_screen) {
+    fixes |= RomDatabase::Mirroring;
+  }
+  if (have.has_battery != best.has_battery) {
+    fixes |= RomDatabase::Battery;
+  }
+  if (have.prg_ram_size != best.prg_ram_size ||
+      have.prg_nvram_size != best.prg_nvram_size ||
+      have.chr_ram_size != best.chr_ram_size ||
+      have.chr_nvram_size != best.chr_nvram_size) {
+    fixes |= RomDatabase::RamSizes;
+  }
+  if (have.timing != best.timing) {
+    fixes |= RomDatabase::Timing;
+  }
+  return fixes;
+}
+
+auto is_rom_file(const fs::path &path) -> bool {
+  std::string extension = path.extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  // compressed ROMs are indexed by the ROM inside
+  return extension == ".nes" || extension == ".gz" || extension == ".zip";
+}
+
+auto list_files(const fs::path &root, std::vector<std::string> &files)
+    -> void {
+  std::error_code error;
+  fs::recursive_directory_iterator it(
+      root, fs::directory_options::skip_permission_denied, error);
+  for (; !error && it != fs::recursive_directory_iterator();
+       it.increment(error)) {
+    if (it->is_regular_file(error) && is_rom_file(it->path())) {
+      files.push_back(it->path().string());
+    }
+  }
+}
+} // namespace
+
+auto RomDatabase::read_file(const std::string &fname) -> bool {
+  std::ifstream stream(fname, std::ifstream::binary);
+  if (!stream.is_open()) {
+    return false;
+  }
+
+  IndexHeader header{};
+  stream.read(reinterpret_cast<char *>(&header), sizeof(IndexHeader));
+  if (!stream || header.magic != IndexHeader::Magic ||
+      header.version != IndexHeader::Version) {
+    return false;
+  }
+
+  // the counts are not trusted with the allocations, the file has to hold
+  // every record and path it claims
+  const std::streampos position = stream.tellg();
+  stream.seekg(0, std::ifstream::end);
+  const std::streamoff remaining = stream.tellg() - position;
+  stream.seekg(position);
+  const uint64_t size =
+      uint64_t(header.entries) * sizeof(IndexRecord) + header.paths_size;
+  if (remaining < 0 || uint64_t(remaining) < size) {
+    return false;
+  }
+
+  std::vector<IndexRecord> records(header.entries);
+  std::string paths(header.paths_size, '\0');
+  stream.read(reinterpret_cast<char *>(records.data()),
+              records.size() * sizeof(IndexRecord));
+  stream.read(paths.data(), paths.size());
+  if (!stream) {
+    return false;
+  }
+
+  std::vector<Entry> entries(records.size());
+  for (size_t i = 0; i < records.size(); i++) {
+    const IndexRecord &record = records[i];
+    if (uint64_t(record.path_offset) + record.path_size > paths.size()) {
+      return false;
+    }
+    // a corrupt record could name a format or timing that does not exist
+    if (record.format >
+            static_cast<uint8_t>(RomDescriptor::Format::Nes20) ||
+        record.timing > static_cast<uint8_t>(RomDescriptor::Timing::Dendy)) {
+      return false;
+    }
+
+    Entry &entry = entries[i];
+    entry.path = paths.substr(record.path_offset, record.path_size);
+    entry.mtime = record.mtime;
+    entry.file_size = record.file_size;
+    entry.crc32 = record.crc32;
+    entry.sha1 = record.sha1;
+    entry.fixes = record.fixes;
+
+    RomDescriptor &descriptor = entry.descriptor;
+    descriptor.format = RomDescriptor::Format(record.format);
+    descriptor.mapper_id = record.mapper_id;
+    descriptor.submapper = record.submapper;
+    descriptor.prg_rom_size = record.prg_rom_size;
+    descriptor.chr_rom_size = record.chr_rom_size;
+    descriptor.prg_ram_size = from_shift(record.ram_shifts[0]);
+    descriptor.prg_nvram_size = from_shift(record.ram_shifts[1]);
+    descriptor.chr_ram_size = from_shift(record.ram_shifts[2]);
+    descriptor.chr_nvram_size = from_shift(record.ram_shifts[3]);
+    descriptor.is_vertical_mirroring = record.flags & 0x01;
+    descriptor.is_four_screen = record.flags & 0x02;
+    descriptor.has_battery = record.flags & 0x04;
+    descriptor.has_trainer = record.flags & 0x08;
+    descriptor.timing = RomDescriptor::Timing(record.timing);
+  }
+
+  m_entries = std::move(entries);
+  index();
+  return true;
+}
+
+auto RomDatabase::write_file(const std::string &fname) const -> bool {
+  std::vector<IndexRecord> records(m_entries.size());
+  std::string paths;
+  for (size_t i = 0; i < m_entries.size(); i++) {
+    const Entry &entry = m_entries[i];
+    const RomDescriptor &descriptor = entry.descriptor;
+    if (entry.path.size() > UINT16_MAX) {
+      return false;
+    }
+
+    IndexRecord &record = records[i];
+    record.mtime = entry.mtime;
+    record.file_size = entry.file_size;
+    record.crc32 = entry.crc32;
+    record.path_offset = static_cast<uint32_t>(paths.size());
+    record.prg_rom_size = static_cast<uint32_t>(descriptor.prg_rom_size);
+    record.chr_rom_size = static_cast<uint32_t>(descriptor.chr_rom_size);
+    record.sha1 = entry.sha1;
+    record.mapper_id = descriptor.mapper_id;
+    record.path_size = static_cast<uint16_t>(entry.path.size());
+    record.submapper = descriptor.submapper;
+    record.format = static_cast<uint8_t>(descriptor.format);
+    record.flags = (descriptor.is_vertical_mirroring ? 0x01 : 0) |
+                   (descriptor.is_four_screen ? 0x02 : 0) |
+                   (descriptor.has_battery ? 0x04 : 0) |
+                   (descriptor.has_trainer ? 0x08 : 0);
+    record.timing = static_cast<uint8_t>(descriptor.timing);
+    record.ram_shifts = {to_shift(descriptor.prg_ram_size),
+                         to_shift(descriptor.prg_nvram_size),
+                         to_shift(descriptor.chr_ram_size),
+                         to_shift(descriptor.chr_nvram_size)};
+    record.fixes = entry.fixes;
+    paths += entry.path;
+  }
+
+  IndexHeader header{IndexHeader::Magic, IndexHeader::Version,
+                     static_cast<uint32_t>(records.size()),
+                     static_cast<uint32_t>(paths.size())};
+
+  // written aside and renamed over, a failed write leaves the old index
+  const std::string temp = fname + ".tmp";
+  {
+    std::ofstream stream(temp, std::ofstream::binary | std::ofstream::trunc);
+    if (!stream.is_open()) {
+      return false;
+    }
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(IndexHeader));
+    stream.write(reinterpret_cast<const char *>(records.data()),
+                 records.size() * sizeof(IndexRecord));
+    stream.write(paths.data(), paths.size());
+    if (!stream.flush()) {
+      return false;
+    }
+  }
+
+  std::error_code error;
+  fs::rename(temp, fname, error);
+  return !error;
+}
+
+auto RomDatabase::scan(const std::string &root, ThreadPool &pool)
+    -> ScanStatistics {
+  // the top level is listed here, the trees below it in parallel
+  std::vector<std::string> files;
+  std::vector<fs::path> directories;
+  std::error_code error;
+  fs::directory_iterator it(root, fs::directory_options::skip_permission_denied,
+                            error);
+  for (; !error && it != fs::directory_iterator(); it.increment(error)) {
+    if (it->is_directory(error)) {
+      directories.push_back(it->path());
+    } else if (it->is_regular_file(error) && is_rom_file(it->path())) {
+      files.push_back(it->path().string());
+    }
+  }
+
+  std::vector<std::vector<std::string>> found(directories.size());
+  pool.parallel_for(directories.size(), [&](size_t i) {
+    list_files(directories[i], found[i]);
+  });
+  for (auto &more : found) {
+    files.insert(files.end(), std::make_move_iterator(more.begin()),
+                 std::make_move_iterator(more.end()));
+  }
+  std::sort(files.begin(), files.end());
+
+  std::unordered_map<std::string, const Entry *> previous;
+  for (const Entry &entry : m_entries) {
+    previous.emplace(entry.path, &entry);
+  }
+
+  enum class Outcome : uint8_t { Rejected, Hashed, Reused };
+  std::vector<Entry> entries(files.size());
+  std::vector<Outcome> outcomes(files.size(), Outcome::Rejected);
+  pool.parallel_for(files.size(), [&](size_t i) {
+    struct stat info {};
+    if (::stat(files[i].c_str(), &info) != 0) {
+      return;
+    }
+
+    Entry &entry = entries[i];
+    entry.path = files[i];
+    entry.mtime = int64_t(info.st_mtim.tv_sec) * 1000000000 +
+                  info.st_mtim.tv_nsec;
+    entry.file_size = static_cast<uint64_t>(info.st_size);
+
+    const auto old = previous.find(entry.path);
+    if (old != previous.end() && old->second->mtime == entry.mtime &&
+        old->second->file_size == entry.file_size) {
+      entry = *old->second;
+      outcomes[i] = Outcome::Reused;
+      return;
+    }
+
+    const auto image = RomImage::from_file(entry.path);
+    if (!image) {
+      return;
+    }
+    entry.descriptor = image->descriptor;
+    entry.crc32 = image->get_crc32();
+    entry.sha1 = Checksum::sha1(image->prg_rom,
+                                image->descriptor.prg_rom_size +
+                                    image->descriptor.chr_rom_size);
+    outcomes[i] = Outcome::Hashed;
+  });
+
+  ScanStatistics statistics;
+  statistics.files = files.size();
+  m_entries.clear();
+  for (size_t i = 0; i < files.size(); i++) {
+    switch (outcomes[i]) {
+    case Outcome::Rejected:
+      statistics.rejected++;
+      continue;
+    case Outcome::Hashed:
+      statistics.hashed++;
+      break;
+    case Outcome::Reused:
+      statistics.reused++;
+      break;
+    }
+    m_entries.push_back(std::move(entries[i]));
+  }
+
+  index();
+  return statistics;
+}
+
+auto RomDatabase::get_entries() const -> const std::vector<Entry> & {
+  return m_entries;
+}
+
+auto RomDatabase::find(uint32_t crc32) const -> const Entry * {
+  const auto best = m_best.find(crc32);
+  return best == m_best.end() ? nullptr : &m_entries[best->second];
+}
+
+auto RomDatabase::correct(uint32_t crc32, RomDescriptor &descriptor) const
+    -> bool {
+  const Entry *best = find(crc32);
+  if (best == nullptr ||
+      get_rank(best->descriptor.format) <= get_rank(descriptor.format) ||
+      best->descriptor.prg_rom_size != descriptor.prg_rom_size ||
+      best->descriptor.chr_rom_size != descriptor.chr_rom_size ||
+      get_fixes(descriptor, best->descriptor) == 0) {
+    return false;
+  }
+
+  const RomDescriptor &from = best->descriptor;
+  descriptor.mapper_id = from.mapper_id;
+  descriptor.submapper = from.submapper;
+  descriptor.prg_ram_size = from.prg_ram_size;
+  descriptor.prg_nvram_size = from.prg_nvram_size;
+  descriptor.chr_ram_size = from.chr_ram_size;
+  descriptor.chr_nvram_size = from.chr_nvram_size;
+  descriptor.has_battery = from.has_battery;
+  descriptor.is_vertical_mirroring = from.is_vertical_mirroring;
+  descriptor.is_four_screen = from.is_four_screen;
+  descriptor.timing = from.timing;
+  return true;
+}
+
+// picks the best header for every dump, the first by path among equals,
+// and notes where the others fall short of it
+auto RomDatabase::index() -> void {
+  m_best.clear();
+  m_best.reserve(m_entries.size());
+  for (size_t i = 0; i < m_entries.size(); i++) {
+    const auto [best, is_new] = m_best.emplace(m_entries[i].crc32, i);
+    if (!is_new && get_rank(m_entries[i].descriptor.format) >
+                       get_rank(m_entries[best->second].descriptor.format)) {
+      best->second = i;
+    }
+  }
+
+  for (Entry &entry : m_entries) {
+    entry.fixes = get_fixes(entry.descriptor,
+                            m_entries[m_best[entry.crc32]].descriptor);
+  }
+}
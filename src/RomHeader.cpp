@@ -0,0 +1,109 @@
+#include "../include/RomHeader.hpp"
+
+#include <cstdint>
+
+namespace {
+// nothing on a cartridge comes anywhere near this
+constexpr uint64_t max_rom_size = uint64_t(1) << 30;
+
+// NES 2.0 sizes: a 12-bit count of units, or 2^E * (2M + 1) bytes when the
+// high nibble is all ones
+auto rom_size(uint8_t low, uint8_t high, uint64_t unit) -> uint64_t {
+  if (high == 0x0f) {
+    const uint8_t exponent = low >> 2;
+    const uint8_t multiplier = low & 0x03;
+    if (exponent >= 30) {
+      return max_rom_size + 1;
+    }
+    return (uint64_t(1) << exponent) * (multiplier * 2 + 1);
+  }
+  return ((uint64_t(high) << 8) | low) * unit;
+}
+
+// RAM sizes are 64 << shift bytes, or none at all
+auto ram_size(uint8_t shift) -> uint64_t { return shift ? 64u << shift : 0; }
+} // namespace
+
+auto RomDescriptor::parse(const RomHeader &header, RomDescriptor &descriptor)
+    -> bool {
+  if (header.magic != RomHeader::Magic) {
+    return false;
+  }
+
+  RomDescriptor result;
+  result.has_trainer = header.flags_6 & 0x04;
+  result.has_battery = header.flags_6 & 0x02;
+  result.is_vertical_mirroring = header.flags_6 & 0x01;
+  result.is_four_screen = header.flags_6 & 0x08;
+
+  const bool is_tail_clear = header.flags_12 == 0 &&
+                             header.flags_13_15[0] == 0 &&
+                             header.flags_13_15[1] == 0 &&
+                             header.flags_13_15[2] == 0;
+  if ((header.flags_7 & 0x0c) == 0x08) {
+    result.format = Format::Nes20;
+  } else if ((header.flags_7 & 0x0c) == 0x00 && is_tail_clear) {
+    result.format = Format::INes;
+  } else {
+    result.format = Format::ArchaicINes;
+  }
+
+  switch (result.format) {
+  case Format::Nes20:
+    result.mapper_id = (header.flags_6 >> 4) | (header.flags_7 & 0xf0) |
+                       ((header.flags_8 & 0x0f) << 8);
+    result.submapper = header.flags_8 >> 4;
+    result.prg_rom_size =
+        rom_size(header.prg_rom_chunks, header.flags_9 & 0x0f, 16384);
+    result.chr_rom_size =
+        rom_size(header.chr_rom_chunks, header.flags_9 >> 4, 8192);
+    result.prg_ram_size = ram_size(header.flags_10 & 0x0f);
+    result.prg_nvram_size = ram_size(header.flags_10 >> 4);
+    result.chr_ram_size = ram_size(header.flags_11 & 0x0f);
+    result.chr_nvram_size = ram_size(header.flags_11 >> 4);
+    result.timing = static_cast<Timing>(header.flags_12 & 0x03);
+    break;
+
+  case Format::INes:
+  case Format::ArchaicINes:
+    result.mapper_id = header.flags_6 >> 4;
+    if (result.format == Format::INes) {
+      result.mapper_id |= header.flags_7 & 0xf0;
+    }
+    result.prg_rom_size = uint64_t(header.prg_rom_chunks) * 16384;
+    result.chr_rom_size = uint64_t(header.chr_rom_chunks) * 8192;
+
+    // iNES counts PRG-RAM in 8kB units, where 0 still means 8kB
+    const uint8_t prg_ram_chunks =
+        result.format == Format::INes ? header.flags_8 : 0;
+    const uint64_t prg_ram = (prg_ram_chunks ? prg_ram_chunks : 1) * 8192;
+    if (result.has_battery) {
+      result.prg_nvram_size = prg_ram;
+    } else {
+      result.prg_ram_size = prg_ram;
+    }
+    result.chr_ram_size = result.chr_rom_size == 0 ? 8192 : 0;
+    if (result.format == Format::INes && (header.flags_9 & 0x01)) {
+      result.timing = Timing::PAL;
+    }
+    break;
+  }
+
+  // a board needs program code, and something for the PPU to fetch
+  if (result.prg_rom_size == 0 || result.prg_rom_size > max_rom_size ||
+      result.chr_rom_size > max_rom_size) {
+    return false;
+  }
+  if (result.chr_rom_size == 0 && result.chr_ram_size == 0 &&
+      result.chr_nvram_size == 0) {
+    return false;
+  }
+
+  descriptor = result;
+  return true;
+}
+
+auto RomDescriptor::get_file_size() const -> uint64_t {
+  return sizeof(RomHeader) + (has_trainer ? 512 : 0) + prg_rom_size +
+         chr_rom_size;
+}
@@ -0,0 +1,133 @@
+#include "../include/RunAhead.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+namespace {
+auto run_to_frame_end(Bus &nes) -> void {
+  do {
+    nes.clock();
+  } while (!nes.m_ppu->m_is_frame_complete);
+  nes.m_ppu->m_is_frame_complete = false;
+}
+} // namespace
+
+RunAhead::RunAhead() = default;
+
+RunAhead::~RunAhead() { set_second_instance(nullptr); }
+
+auto RunAhead::set_frames(uint8_t frames) -> void {
+  m_frames = std::min(frames, MaxFrames);
+}
+
+auto RunAhead::get_frames() const -> uint8_t { return m_frames; }
+
+auto RunAhead::set_second_instance(const std::shared_ptr<Cartridge> &cartridge)
+    -> void {
+  if (m_worker.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_quit = true;
+    }
+    m_wake.notify_one();
+    m_worker.join();
+    m_quit = false;
+    m_has_job = false;
+  }
+  m_second.reset();
+  m_has_picture = false;
+
+  if (cartridge) {
+    m_second = std::make_unique<Bus>();
+    m_second->insert_cartridge(cartridge);
+    m_worker = std::thread(&RunAhead::work, this);
+  }
+}
+
+auto RunAhead::has_second_instance() const -> bool {
+  return m_second != nullptr;
+}
+
+auto RunAhead::run_frame(Bus &nes, bool is_shown) -> void {
+  if (m_frames == 0) {
+    nes.m_ppu->set_pixel_output(is_shown);
+    run_to_frame_end(nes);
+    m_has_picture = false;
+  } else if (m_second) {
+    run_second_instance(nes, is_shown);
+  } else {
+    run_in_place(nes, is_shown);
+  }
+  nes.m_ppu->set_pixel_output(true);
+}
+
+auto RunAhead::run_in_place(Bus &nes, bool is_shown) -> void {
+  nes.m_ppu->set_pixel_output(false);
+  run_to_frame_end(nes);
+  nes.save_state(*m_state);
+
+  // the speculative frames must not reach the save file; if battery RAM
+  // cannot be kept out of it, the last picture stays up instead
+  if (!nes.m_cartridge->detach_battery()) {
+    return;
+  }
+  for (uint8_t i = 1; i <= m_frames; i++) {
+    nes.m_ppu->set_pixel_output(is_shown && i == m_frames);
+    run_to_frame_end(nes);
+  }
+  nes.m_cartridge->attach_battery();
+  nes.load_state(*m_state);
+}
+
+auto RunAhead::run_second_instance(Bus &nes, bool is_shown) -> void {
+  // the real frame overlaps with the speculative frames of the last one
+  nes.m_ppu->set_pixel_output(false);
+  run_to_frame_end(nes);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_idle.wait(lock, [this]() { return !m_has_job; });
+
+  if (is_shown && m_has_picture) {
+    std::memcpy(nes.m_ppu->get_framebuffer(),
+                m_second->m_ppu->get_framebuffer(),
+                PPU::ScreenWidth * PPU::ScreenHeight *
+                    PPU::get_bytes_per_pixel(nes.m_ppu->get_pixel_format()));
+  }
+
+  nes.save_state(*m_second_state);
+  m_second->m_ppu->set_framebuffer(nullptr, nes.m_ppu->get_pixel_format());
+  m_has_job = true;
+  m_job_frames = static_cast<uint8_t>(m_frames + 1);
+  m_is_job_shown = is_shown;
+  m_has_picture = is_shown;
+  lock.unlock();
+  m_wake.notify_one();
+}
+
+auto RunAhead::work() -> void {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_wake.wait(lock, [this]() { return m_quit || m_has_job; });
+    if (m_quit) {
+      return;
+    }
+
+    // the job is only handed over while the worker is idle, so its state
+    // and framebuffer can be used unlocked
+    lock.unlock();
+    Bus &second = *m_second;
+    if (second.load_state(*m_second_state)) {
+      for (uint8_t i = 1; i <= m_job_frames; i++) {
+        second.m_ppu->set_pixel_output(m_is_job_shown && i == m_job_frames);
+        run_to_frame_end(second);
+      }
+    }
+    lock.lock();
+
+    m_has_job = false;
+    m_idle.notify_all();
+  }
+}
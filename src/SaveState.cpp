@@ -0,0 +1,43 @@
+#include "../include/SaveState.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+
+auto SaveState::is_valid() const -> bool {
+  return magic == Magic && version == Version && size == sizeof(SaveState);
+}
+
+auto SaveState::write_file_async(const SaveState &state,
+                                 const std::string &fname)
+    -> std::future<bool> {
+  auto snapshot = std::make_shared<SaveState>(state);
+
+  return std::async(std::launch::async, [snapshot, fname]() {
+    std::ofstream stream(fname, std::ofstream::binary | std::ofstream::trunc);
+    if (!stream.is_open()) {
+      return false;
+    }
+    stream.write(reinterpret_cast<const char *>(snapshot.get()),
+                 sizeof(SaveState));
+    return stream.good();
+  });
+}
+
+auto SaveState::read_file(const std::string &fname, SaveState &state) -> bool {
+  std::ifstream stream(fname, std::ifstream::binary);
+  if (!stream.is_open()) {
+    return false;
+  }
+
+  auto snapshot = std::make_unique<SaveState>();
+  stream.read(reinterpret_cast<char *>(snapshot.get()), sizeof(SaveState));
+  if (stream.gcount() != sizeof(SaveState) || !snapshot->is_valid()) {
+    return false;
+  }
+
+  state = *snapshot;
+  return true;
+}
@@ -0,0 +1,111 @@
+#include "../include/ThreadPool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+ThreadPool::ThreadPool(size_t threads) {
+  threads = std::max<size_t>(threads, 1);
+  for (size_t i = 0; i < threads; i++) {
+    m_queues.push_back(std::make_unique<Queue>());
+  }
+  for (size_t i = 1; i < threads; i++) {
+    m_workers.emplace_back(&ThreadPool::work, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+  }
+  m_wake.notify_all();
+  for (auto &worker : m_workers) {
+    worker.join();
+  }
+}
+
+auto ThreadPool::get_thread_count() const -> size_t { return m_queues.size(); }
+
+auto ThreadPool::parallel_for(size_t count,
+                              const std::function<void(size_t)> &task)
+    -> void {
+  if (count == 0) {
+    return;
+  }
+
+  // published to the workers by the queue mutexes taken below
+  m_task = &task;
+  m_remaining = count;
+  for (size_t i = 0; i < count; i++) {
+    Queue &queue = *m_queues[i % m_queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.items.push_back(i);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_generation += 1;
+  }
+  m_wake.notify_all();
+
+  run_tasks(0);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this]() { return m_remaining == 0; });
+}
+
+auto ThreadPool::work(size_t queue) -> void {
+  uint64_t generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [&]() {
+        return m_quit || m_generation != generation;
+      });
+      if (m_quit) {
+        return;
+      }
+      generation = m_generation;
+    }
+    run_tasks(queue);
+  }
+}
+
+auto ThreadPool::run_tasks(size_t queue) -> void {
+  size_t item = 0;
+  while (take(queue, item)) {
+    (*m_task)(item);
+    if (m_remaining.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_done.notify_all();
+    }
+  }
+}
+
+auto ThreadPool::take(size_t queue, size_t &item) -> bool {
+  {
+    Queue &own = *m_queues[queue];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.items.empty()) {
+      item = own.items.back();
+      own.items.pop_back();
+      return true;
+    }
+  }
+
+  for (size_t i = 1; i < m_queues.size(); i++) {
+    Queue &victim = *m_queues[(queue + i) % m_queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.items.empty()) {
+      item = victim.items.front();
+      victim.items.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
@@ -1,181 +1,516 @@
-#include "../include/Bus.hpp"
-#include "../include/CPU.hpp"
-
-#include <iostream>
-#include <sstream>
-
-#define OLC_PGE_APPLICATION
-#include "../include/olcPixelGameEngine.hpp"
-
-class Demo_olc2C02 : public olc::PixelGameEngine {
-public:
-  Demo_olc2C02() { sAppName = "olc2C02 Demonstration"; }
-
-private:
-  // The NES
-  Bus m_nes;
-  std::shared_ptr<Cartridge> m_cart;
-  bool is_running = false;
-  float residual_time = 0.0f;
-
-private:
-  // Support Utilities
-  std::map<uint16_t, std::string> map_asm;
-
-  std::string hex(uint32_t n, uint8_t d) {
-    std::string s(d, '0');
-    for (int i = d - 1; i >= 0; i--, n >>= 4)
-      s[i] = "0123456789ABCDEF"[n & 0xF];
-    return s;
-  };
-
-  void DrawRam(int x, int y, uint16_t addr, int rows, int cols) {
-    const int nRamX = x;
-    int nRamY = y;
-    for (int row = 0; row < rows; row++) {
-      std::string str_offset = "$" + hex(addr, 4) + ":";
-      for (int col = 0; col < cols; col++) {
-        str_offset += " " + hex(m_nes.read_cpu(addr), 2);
-        addr += 1;
-      }
-      DrawString(nRamX, nRamY, str_offset);
-      nRamY += 10;
-    }
-  }
-
-  void DrawCpu(int x, int y) {
-    std::string status = "STATUS: ";
-    DrawString(x, y, "STATUS:", olc::WHITE);
-    DrawString(x + 64, y, "N",
-               m_nes.m_cpu->status & CPU::Flags::N ? olc::GREEN : olc::RED);
-    DrawString(x + 80, y, "V",
-               m_nes.m_cpu->status & CPU::Flags::V ? olc::GREEN : olc::RED);
-    DrawString(x + 96, y, "-",
-               m_nes.m_cpu->status & CPU::Flags::U ? olc::GREEN : olc::RED);
-    DrawString(x + 112, y, "B",
-               m_nes.m_cpu->status & CPU::Flags::B ? olc::GREEN : olc::RED);
-    DrawString(x + 128, y, "D",
-               m_nes.m_cpu->status & CPU::Flags::D ? olc::GREEN : olc::RED);
-    DrawString(x + 144, y, "I",
-               m_nes.m_cpu->status & CPU::Flags::I ? olc::GREEN : olc::RED);
-    DrawString(x + 160, y, "Z",
-               m_nes.m_cpu->status & CPU::Flags::Z ? olc::GREEN : olc::RED);
-    DrawString(x + 178, y, "C",
-               m_nes.m_cpu->status & CPU::Flags::C ? olc::GREEN : olc::RED);
-    DrawString(x, y + 10, "PC: $" + hex(m_nes.m_cpu->pc, 4));
-    DrawString(x, y + 20,
-               "A: $" + hex(m_nes.m_cpu->a, 2) + "  [" +
-                   std::to_string(m_nes.m_cpu->a) + "]");
-    DrawString(x, y + 30,
-               "X: $" + hex(m_nes.m_cpu->x, 2) + "  [" +
-                   std::to_string(m_nes.m_cpu->x) + "]");
-    DrawString(x, y + 40,
-               "Y: $" + hex(m_nes.m_cpu->y, 2) + "  [" +
-                   std::to_string(m_nes.m_cpu->y) + "]");
-    DrawString(x, y + 50, "Stack P: $" + hex(m_nes.m_cpu->stkp, 4));
-  }
-
-  void DrawCode(int x, int y, int nLines) {
-    auto it_a = map_asm.find(m_nes.m_cpu->pc);
-    int nLineY = (nLines >> 1) * 10 + y;
-    if (it_a != map_asm.end()) {
-      DrawString(x, nLineY, (*it_a).second, olc::CYAN);
-      while (nLineY < (nLines * 10) + y) {
-        nLineY += 10;
-        if (++it_a != map_asm.end()) {
-          DrawString(x, nLineY, (*it_a).second);
-        }
-      }
-    }
-
-    it_a = map_asm.find(m_nes.m_cpu->pc);
-    nLineY = (nLines >> 1) * 10 + y;
-    if (it_a != map_asm.end()) {
-      while (nLineY > y) {
-        nLineY -= 10;
-        if (--it_a != map_asm.end()) {
-          DrawString(x, nLineY, (*it_a).second);
-        }
-      }
-    }
-  }
-
-  bool OnUserCreate() override {
-    // Load the cartridge
-    m_cart = std::make_shared<Cartridge>("nestest.m_nes");
-    if (!m_cart->is_valid_image())
-      return false;
-
-    // Insert into NES
-    m_nes.insert_cartridge(m_cart);
-
-    // Extract dissassembly
-    map_asm = m_nes.m_cpu->disassemble(0x0000, 0xFFFF);
-
-    // Reset NES
-    m_nes.reset();
-    return true;
-  }
-
-  bool OnUserUpdate(float elapsed_time) override {
-    Clear(olc::DARK_BLUE);
-
-    if (is_running) {
-      if (residual_time > 0.0f)
-        residual_time -= elapsed_time;
-      else {
-        residual_time += (1.0f / 60.0f) - elapsed_time;
-        do {
-          m_nes.clock();
-        } while (!m_nes.m_ppu->m_is_frame_complete);
-        m_nes.m_ppu->m_is_frame_complete = false;
-      }
-    } else {
-      // Emulate code step-by-step
-      if (GetKey(olc::Key::C).bPressed) {
-        // Clock enough times to execute a whole CPU instruction
-        do {
-          m_nes.clock();
-        } while (!m_nes.m_cpu->is_complete());
-        // CPU clock runs slower than system clock, so it may be
-        // complete for additional system clock cycles. Drain
-        // those out
-        do {
-          m_nes.clock();
-        } while (m_nes.m_cpu->is_complete());
-      }
-
-      // Emulate one whole frame
-      if (GetKey(olc::Key::F).bPressed) {
-        // Clock enough times to draw a single frame
-        do {
-          m_nes.clock();
-        } while (!m_nes.m_ppu->m_is_frame_complete);
-        // Use residual clock cycles to complete current instruction
-        do {
-          m_nes.clock();
-        } while (!m_nes.m_cpu->is_complete());
-        // Reset frame completion flag
-        m_nes.m_ppu->m_is_frame_complete = false;
-      }
-    }
-
-    if (GetKey(olc::Key::SPACE).bPressed)
-      is_running = !is_running;
-    if (GetKey(olc::Key::R).bPressed)
-      m_nes.reset();
-
-    DrawCpu(516, 2);
-    DrawCode(516, 72, 26);
-
-    DrawSprite(0, 0, &m_nes.m_ppu->get_screen(), 2);
-    return true;
-  }
-};
-
-int main() {
-  Demo_olc2C02 demo;
-  demo.Construct(780, 480, 2, 2);
-  demo.Start();
-  return 0;
+#include "../include/Bus.hpp"
+#include "../include/CPU.hpp"
+#include "../include/FramePacer.hpp"
+#include "../include/Movie.hpp"
+#include "../include/Rewind.hpp"
+#include "../include/RomCache.hpp"
+#include "../include/RomDatabase.hpp"
+#include "../include/RunAhead.hpp"
+#include "../include/SaveState.hpp"
+#include "../include/TripleBuffer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include "../include/olcPixelGameEngine.hpp"
+
+class Demo_olc2C02 : public olc::PixelGameEngine {
+public:
+  Demo_olc2C02() { sAppName = "olc2C02 Demonstration"; }
+
+private:
+  // Everything the UI thread draws, published by the emulation thread
+  struct Frame {
+    std::array<uint32_t, PPU::ScreenWidth * PPU::ScreenHeight> pixels;
+    std::array<std::array<uint32_t, 128 * 128>, 2> pattern;
+    uint8_t a, x, y, stkp, status;
+    uint16_t pc;
+    FramePacer::Rate rate;
+    FramePacer::Statistics pacing;
+    bool is_turbo;
+    bool is_rewinding;
+    size_t rewind_frames; // how far back rewinding can currently go
+    uint8_t run_ahead;
+    bool is_second_instance;
+    bool is_recording;
+    double speed; // emulated frames relative to the console refresh rate
+  };
+
+  // In turbo mode only one frame in this many produces pixels
+  static constexpr uint32_t turbo_frame_skip = 8;
+
+  // The NES, owned by the emulation thread once it is started
+  Bus m_nes;
+  std::shared_ptr<Cartridge> m_cart;
+  const std::string m_rom_name{"nestest.m_nes"};
+  std::thread m_emulation;
+  TripleBuffer<Frame> m_frames;
+  FramePacer m_pacer;
+  RewindBuffer m_rewind;
+  RunAhead m_run_ahead;
+  Movie m_movie;
+
+  // Requests from the UI thread
+  std::atomic<bool> m_quit{false};
+  std::atomic<bool> is_running{false};
+  std::atomic<bool> m_step_instruction{false};
+  std::atomic<bool> m_step_frame{false};
+  std::atomic<bool> m_reset{false};
+  std::atomic<uint8_t> m_selected_palette{0x00};
+  std::atomic<FramePacer::Rate> m_rate{FramePacer::Rate::NTSC};
+  std::atomic<bool> m_turbo{false};
+  std::atomic<bool> m_save{false};
+  std::atomic<bool> m_load{false};
+  std::atomic<bool> m_rewinding{false};
+  std::atomic<uint8_t> m_run_ahead_frames{0};
+  std::atomic<bool> m_second_instance{false};
+  std::atomic<uint8_t> m_input{0x00};
+  std::atomic<bool> m_record{false};
+
+  // Owned by the emulation thread
+  uint32_t m_frames_skipped = 0;
+  uint32_t m_speed_frames = 0;
+  FramePacer::clock::time_point m_speed_start = FramePacer::clock::now();
+  double m_speed = 0.0;
+  std::unique_ptr<SaveState> m_state;
+  std::future<bool> m_state_written;
+  std::unique_ptr<SaveState> m_rewind_state = std::make_unique<SaveState>();
+  bool m_is_recording = false;
+
+  // Owned by the UI thread
+  olc::Sprite m_screen{PPU::ScreenWidth, PPU::ScreenHeight};
+  std::array<olc::Sprite, 2> m_pattern{olc::Sprite{128, 128},
+                                       olc::Sprite{128, 128}};
+
+private:
+  // Support Utilities
+  std::map<uint16_t, std::string> map_asm;
+
+  std::string hex(uint32_t n, uint8_t d) {
+    std::string s(d, '0');
+    for (int i = d - 1; i >= 0; i--, n >>= 4)
+      s[i] = "0123456789ABCDEF"[n & 0xF];
+    return s;
+  };
+
+  void DrawRam(int x, int y, uint16_t addr, int rows, int cols) {
+    const int nRamX = x;
+    int nRamY = y;
+    for (int row = 0; row < rows; row++) {
+      std::string str_offset = "$" + hex(addr, 4) + ":";
+      for (int col = 0; col < cols; col++) {
+        str_offset += " " + hex(m_nes.read_cpu(addr), 2);
+        addr += 1;
+      }
+      DrawString(nRamX, nRamY, str_offset);
+      nRamY += 10;
+    }
+  }
+
+  void DrawCpu(int x, int y, const Frame &cpu) {
+    std::string status = "STATUS: ";
+    DrawString(x, y, "STATUS:", olc::WHITE);
+    DrawString(x + 64, y, "N",
+               cpu.status & CPU::Flags::N ? olc::GREEN : olc::RED);
+    DrawString(x + 80, y, "V",
+               cpu.status & CPU::Flags::V ? olc::GREEN : olc::RED);
+    DrawString(x + 96, y, "-",
+               cpu.status & CPU::Flags::U ? olc::GREEN : olc::RED);
+    DrawString(x + 112, y, "B",
+               cpu.status & CPU::Flags::B ? olc::GREEN : olc::RED);
+    DrawString(x + 128, y, "D",
+               cpu.status & CPU::Flags::D ? olc::GREEN : olc::RED);
+    DrawString(x + 144, y, "I",
+               cpu.status & CPU::Flags::I ? olc::GREEN : olc::RED);
+    DrawString(x + 160, y, "Z",
+               cpu.status & CPU::Flags::Z ? olc::GREEN : olc::RED);
+    DrawString(x + 178, y, "C",
+               cpu.status & CPU::Flags::C ? olc::GREEN : olc::RED);
+    DrawString(x, y + 10, "PC: $" + hex(cpu.pc, 4));
+    DrawString(x, y + 20,
+               "A: $" + hex(cpu.a, 2) + "  [" +
+                   std::to_string(cpu.a) + "]");
+    DrawString(x, y + 30,
+               "X: $" + hex(cpu.x, 2) + "  [" +
+                   std::to_string(cpu.x) + "]");
+    DrawString(x, y + 40,
+               "Y: $" + hex(cpu.y, 2) + "  [" +
+                   std::to_string(cpu.y) + "]");
+    DrawString(x, y + 50, "Stack P: $" + hex(cpu.stkp, 4));
+    DrawString(x, y + 60,
+               "Run Ahead: " + std::to_string(cpu.run_ahead) +
+                   (cpu.is_second_instance ? " [2ND]" : ""));
+  }
+
+  void DrawPacing(int x, int y, const Frame &frame) {
+    static const char *rates[] = {"NTSC", "PAL", "UNCAPPED"};
+    std::ostringstream text;
+    text.precision(2);
+    text << std::fixed;
+    if (frame.is_recording) {
+      text << "REC ";
+    }
+    if (frame.is_rewinding) {
+      text << "REWIND " << frame.rewind_frames << " FRAMES LEFT";
+    } else if (frame.is_turbo) {
+      text << "TURBO x" << frame.speed;
+    } else {
+      text << rates[static_cast<uint8_t>(frame.rate)] << " JIT "
+           << frame.pacing.jitter_ms << "ms MAX " << frame.pacing.max_late_ms
+           << "ms";
+    }
+    DrawString(x, y, text.str());
+  }
+
+  void DrawCode(int x, int y, int nLines, uint16_t pc) {
+    auto it_a = map_asm.find(pc);
+    int nLineY = (nLines >> 1) * 10 + y;
+    if (it_a != map_asm.end()) {
+      DrawString(x, nLineY, (*it_a).second, olc::CYAN);
+      while (nLineY < (nLines * 10) + y) {
+        nLineY += 10;
+        if (++it_a != map_asm.end()) {
+          DrawString(x, nLineY, (*it_a).second);
+        }
+      }
+    }
+
+    it_a = map_asm.find(pc);
+    nLineY = (nLines >> 1) * 10 + y;
+    if (it_a != map_asm.end()) {
+      while (nLineY > y) {
+        nLineY -= 10;
+        if (--it_a != map_asm.end()) {
+          DrawString(x, nLineY, (*it_a).second);
+        }
+      }
+    }
+  }
+
+  // Hands the state of the NES over to the UI thread
+  void PublishFrame(bool is_mid_frame) {
+    Frame &frame = m_frames.back();
+    frame.a = m_nes.m_cpu->a;
+    frame.x = m_nes.m_cpu->x;
+    frame.y = m_nes.m_cpu->y;
+    frame.stkp = m_nes.m_cpu->stkp;
+    frame.status = m_nes.m_cpu->status;
+    frame.pc = m_nes.m_cpu->pc;
+    frame.rate = m_pacer.get_rate();
+    frame.pacing = m_pacer.get_statistics();
+    frame.is_turbo = m_turbo;
+    frame.is_rewinding = m_rewinding;
+    frame.rewind_frames = m_rewind.get_frame_count();
+    frame.run_ahead = m_run_ahead.get_frames();
+    frame.is_second_instance = m_run_ahead.has_second_instance();
+    frame.is_recording = m_is_recording;
+    frame.speed = m_speed;
+    for (uint8_t i = 0; i < 2; i++) {
+      std::memcpy(frame.pattern[i].data(),
+                  m_nes.m_ppu->get_table_pattern(i, m_selected_palette)
+                      .GetData(),
+                  sizeof(frame.pattern[i]));
+    }
+
+    m_frames.publish();
+
+    // A partially drawn frame carries on in the next buffer
+    if (is_mid_frame) {
+      m_frames.back().pixels = frame.pixels;
+    }
+    m_nes.m_ppu->set_framebuffer(m_frames.back().pixels.data(),
+                                 PPU::PixelFormat::RGBA);
+  }
+
+  // Measures emulated frames per second against the console's own rate
+  void CountFrame() {
+    m_speed_frames += 1;
+    const auto now = FramePacer::clock::now();
+    const std::chrono::duration<double> elapsed = now - m_speed_start;
+    if (elapsed.count() >= 0.5) {
+      m_speed = m_speed_frames / elapsed.count() /
+                FramePacer::get_frequency(m_pacer.get_rate());
+      m_speed_frames = 0;
+      m_speed_start = now;
+    }
+  }
+
+  // Quick save slot, mirrored to disk without blocking emulation
+  void SaveSnapshot() {
+    if (!m_state)
+      m_state = std::make_unique<SaveState>();
+    m_nes.save_state(*m_state);
+    m_state_written =
+        SaveState::write_file_async(*m_state, m_rom_name + ".state");
+  }
+
+  bool LoadSnapshot() {
+    if (!m_state) {
+      auto state = std::make_unique<SaveState>();
+      if (!SaveState::read_file(m_rom_name + ".state", *state))
+        return false;
+      m_state = std::move(state);
+    }
+    return m_nes.load_state(*m_state);
+  }
+
+  // Movies start from a snapshot of the current state and only hold frames
+  // run normally; anything else that moves the console ends the recording
+  void StartRecording() {
+    m_nes.save_state(*m_rewind_state);
+    m_movie.start_from_state(*m_rewind_state);
+    m_is_recording = true;
+  }
+
+  void StopRecording() {
+    if (!m_is_recording)
+      return;
+    m_is_recording = false;
+    m_record = false;
+    if (!m_movie.write_file(m_rom_name + ".movie"))
+      std::cerr << "unable to write " << m_rom_name << ".movie\n";
+  }
+
+  void Emulate() {
+    while (!m_quit) {
+      if (m_rate != m_pacer.get_rate()) {
+        m_pacer.set_rate(m_rate);
+        m_pacer.reset_statistics();
+      }
+
+      if (m_second_instance != m_run_ahead.has_second_instance()) {
+        m_run_ahead.set_second_instance(m_second_instance ? m_cart->clone()
+                                                          : nullptr);
+      }
+
+      if (m_record && !m_is_recording) {
+        StartRecording();
+      } else if (!m_record && m_is_recording) {
+        StopRecording();
+      }
+
+      if (m_reset.exchange(false)) {
+        StopRecording();
+        m_nes.reset();
+        PublishFrame(true);
+      }
+
+      if (m_save.exchange(false)) {
+        SaveSnapshot();
+      }
+      if (m_load.exchange(false) && LoadSnapshot()) {
+        StopRecording();
+        PublishFrame(true);
+      }
+
+      if (is_running) {
+        // Rewinding replays the frame after each recorded state, so every
+        // step back is drawn; otherwise the state going into the frame is
+        // recorded, the packing happens on the rewind buffer's own thread
+        const bool is_rewinding = m_rewinding;
+        if (is_rewinding) {
+          StopRecording();
+          if (m_rewind.pop(*m_rewind_state))
+            m_nes.load_state(*m_rewind_state);
+        } else {
+          m_nes.m_controller = {m_input.load(), 0x00};
+          if (m_is_recording)
+            m_movie.record(m_nes.m_controller);
+          m_nes.save_state(*m_rewind_state);
+          m_rewind.push(*m_rewind_state);
+        }
+
+        // Turbo runs unpaced and only draws every few frames
+        const bool is_turbo = m_turbo && !is_rewinding;
+        const bool is_shown =
+            !is_turbo || ++m_frames_skipped >= turbo_frame_skip;
+
+        // Hidden frames are not worth running ahead for
+        m_run_ahead.set_frames(is_turbo ? 0 : m_run_ahead_frames.load());
+        m_run_ahead.run_frame(m_nes, is_shown);
+        CountFrame();
+
+        if (is_shown) {
+          m_frames_skipped = 0;
+          PublishFrame(false);
+        }
+        if (is_turbo) {
+          m_pacer.resync();
+        } else {
+          m_pacer.wait();
+        }
+        continue;
+      }
+
+      m_nes.m_ppu->set_pixel_output(true);
+
+      // Emulate code step-by-step
+      if (m_step_instruction.exchange(false)) {
+        StopRecording();
+        // Clock enough times to execute a whole CPU instruction
+        do {
+          m_nes.clock();
+        } while (!m_nes.m_cpu->is_complete());
+        // CPU clock runs slower than system clock, so it may be
+        // complete for additional system clock cycles. Drain
+        // those out
+        do {
+          m_nes.clock();
+        } while (m_nes.m_cpu->is_complete());
+        PublishFrame(true);
+      }
+
+      // Emulate one whole frame
+      else if (m_step_frame.exchange(false)) {
+        StopRecording();
+        // Clock enough times to draw a single frame
+        do {
+          m_nes.clock();
+        } while (!m_nes.m_ppu->m_is_frame_complete);
+        // Use residual clock cycles to complete current instruction
+        do {
+          m_nes.clock();
+        } while (!m_nes.m_cpu->is_complete());
+        // Reset frame completion flag
+        m_nes.m_ppu->m_is_frame_complete = false;
+        PublishFrame(true);
+      }
+
+      else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      // Pausing must not be paid back as a burst of frames
+      m_pacer.resync();
+    }
+  }
+
+  bool OnUserCreate() override {
+    // Load the cartridge
+    m_cart = std::make_shared<Cartridge>(m_rom_name, m_rom_name + ".sav");
+    if (!m_cart->is_valid_image())
+      return false;
+    if (m_cart->get_descriptor().has_battery && !m_cart->is_battery_saved())
+      std::cerr << "unable to open " << m_rom_name << ".sav, the game will "
+                << "not keep its saves\n";
+
+    // Pace PAL games at their own rate
+    if (m_cart->get_descriptor().timing == RomDescriptor::Timing::PAL)
+      m_rate = FramePacer::Rate::PAL;
+
+    // Insert into NES
+    m_nes.insert_cartridge(m_cart);
+
+    // Extract dissassembly
+    map_asm = m_nes.m_cpu->disassemble(0x0000, 0xFFFF);
+
+    // Reset NES
+    m_nes.reset();
+
+    // The PPU renders straight into the frame buffers handed to the UI
+    m_nes.m_ppu->set_framebuffer(m_frames.back().pixels.data(),
+                                 PPU::PixelFormat::RGBA);
+    PublishFrame(true);
+    m_emulation = std::thread(&Demo_olc2C02::Emulate, this);
+    return true;
+  }
+
+  bool OnUserDestroy() override {
+    m_quit = true;
+    if (m_emulation.joinable())
+      m_emulation.join();
+    return true;
+  }
+
+  bool OnUserUpdate(float elapsed_time) override {
+    (void)elapsed_time;
+    Clear(olc::DARK_BLUE);
+
+    if (GetKey(olc::Key::SPACE).bPressed)
+      is_running = !is_running;
+    if (GetKey(olc::Key::C).bPressed)
+      m_step_instruction = true;
+    if (GetKey(olc::Key::F).bPressed)
+      m_step_frame = true;
+    if (GetKey(olc::Key::R).bPressed)
+      m_reset = true;
+    if (GetKey(olc::Key::P).bPressed)
+      m_selected_palette = (m_selected_palette + 1) & 0x07;
+    if (GetKey(olc::Key::F5).bPressed)
+      m_save = true;
+    if (GetKey(olc::Key::F9).bPressed)
+      m_load = true;
+    if (GetKey(olc::Key::T).bPressed)
+      m_turbo = !m_turbo;
+    m_rewinding = GetKey(olc::Key::BACK).bHeld;
+    if (GetKey(olc::Key::A).bPressed)
+      m_run_ahead_frames = (m_run_ahead_frames + 1) % (RunAhead::MaxFrames + 1);
+    if (GetKey(olc::Key::S).bPressed)
+      m_second_instance = !m_second_instance;
+    if (GetKey(olc::Key::M).bPressed)
+      m_record = !m_record;
+
+    // Controller 1, bit 7 down to bit 0
+    m_input = (GetKey(olc::Key::X).bHeld ? 0x80 : 0x00) |
+              (GetKey(olc::Key::Z).bHeld ? 0x40 : 0x00) |
+              (GetKey(olc::Key::SHIFT).bHeld ? 0x20 : 0x00) |
+              (GetKey(olc::Key::ENTER).bHeld ? 0x10 : 0x00) |
+              (GetKey(olc::Key::UP).bHeld ? 0x08 : 0x00) |
+              (GetKey(olc::Key::DOWN).bHeld ? 0x04 : 0x00) |
+              (GetKey(olc::Key::LEFT).bHeld ? 0x02 : 0x00) |
+              (GetKey(olc::Key::RIGHT).bHeld ? 0x01 : 0x00);
+    if (GetKey(olc::Key::N).bPressed)
+      m_rate = static_cast<FramePacer::Rate>(
+          (static_cast<uint8_t>(m_rate.load()) + 1) % 3);
+
+    // Only blit when the emulation thread finished something new
+    if (m_frames.update()) {
+      const Frame &frame = m_frames.front();
+      std::memcpy(reinterpret_cast<uint32_t *>(m_screen.GetData()),
+                  frame.pixels.data(), sizeof(frame.pixels));
+      for (uint8_t i = 0; i < 2; i++) {
+        std::memcpy(reinterpret_cast<uint32_t *>(m_pattern[i].GetData()),
+                    frame.pattern[i].data(), sizeof(frame.pattern[i]));
+      }
+    }
+
+    const Frame &frame = m_frames.front();
+    DrawCpu(516, 2, frame);
+    DrawCode(516, 72, 26, frame.pc);
+    DrawPacing(516, 336, frame);
+
+    DrawSprite(516, 348, &m_pattern[0]);
+    DrawSprite(648, 348, &m_pattern[1]);
+
+    DrawSprite(0, 0, &m_screen, 2);
+    return true;
+  }
+};
+
+int main(int argc, char *argv[]) {
+  // an optional .pal file replaces the built-in colours
+  if (argc > 1 && !PPU::load_palette(argv[1])) {
+    std::cerr << "unable to load palette " << argv[1] << '\n';
+    return 1;
+  }
+
+  // and an index written by NESDebRomScan corrects bad headers
+  if (argc > 2) {
+    auto database = std::make_shared<RomDatabase>();
+    if (!database->read_file(argv[2])) {
+      std::cerr << "unable to read ROM index " << argv[2] << '\n';
+      return 1;
+    }
+    RomCache::set_database(database);
+  }
+
+  Demo_olc2C02 demo;
+  demo.Construct(780, 480, 2, 2);
+  demo.Start();
+  return 0;
 }
\ No newline at end of file
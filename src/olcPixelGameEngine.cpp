@@ -0,0 +1,3 @@
+// the single translation unit holding the olc::PixelGameEngine implementation
+#define OLC_PGE_APPLICATION
+#include "../include/olcPixelGameEngine.hpp"
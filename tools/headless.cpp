@@ -0,0 +1,237 @@
+// Replays an input movie as fast as the host allows, for benchmarks on real
+// gameplay and for bisecting desyncs between builds:
+//
+//   NESDebHeadless <rom> <movie> [--no-video] [--hash-every N]
+//                  [--netplay-latency MS] [--batch N [--threads T]]
+//                  [--index FILE]
+//
+// --hash-every prints a hash of the whole console state every N frames; the
+// first line two builds disagree on brackets the frame that desynced.
+//
+// --netplay-latency plays the movie as two rollback netplay peers, one per
+// controller port, over a loopback transport with the given latency, paced
+// at the NTSC rate. Both must end in the state a plain replay ends in.
+//
+// --batch replays the movie on N consoles at once over T threads, all cores
+// by default, to measure how throughput scales; every console must end in
+// the same state.
+//
+// --index corrects the ROM's header from an index written by NESDebRomScan.
+//
+// Battery RAM starts cleared and is never saved, so no replay depends on
+// what a save file next to the ROM holds.
+
+#include "../include/BatchRunner.hpp"
+#include "../include/Bus.hpp"
+#include "../include/Cartridge.hpp"
+#include "../include/FramePacer.hpp"
+#include "../include/Movie.hpp"
+#include "../include/Netplay.hpp"
+#include "../include/RomCache.hpp"
+#include "../include/RomDatabase.hpp"
+#include "../include/SaveState.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+auto hash_state(const SaveState &state) -> uint64_t {
+  // FNV-1a
+  const auto *bytes = reinterpret_cast<const uint8_t *>(&state);
+  uint64_t hash = 0xcbf29ce484222325;
+  for (size_t i = 0; i < sizeof(SaveState); i++) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3;
+  }
+  return hash;
+}
+
+auto hash_console(const Bus &nes) -> uint64_t {
+  auto state = std::make_unique<SaveState>();
+  nes.save_state(*state);
+  return hash_state(*state);
+}
+
+auto usage() -> int {
+  std::cerr << "usage: NESDebHeadless <rom> <movie> [--no-video] "
+               "[--hash-every N] [--netplay-latency MS] "
+               "[--batch N [--threads T]] [--index FILE]\n";
+  return 2;
+}
+
+auto replay(Bus &nes, const Movie &movie, size_t hash_every) -> void {
+  const auto start = std::chrono::steady_clock::now();
+
+  for (size_t frame = 0; frame < movie.get_frame_count(); frame++) {
+    nes.m_controller = movie.get_input(frame);
+    do {
+      nes.clock();
+    } while (!nes.m_ppu->m_is_frame_complete);
+    nes.m_ppu->m_is_frame_complete = false;
+
+    if (hash_every != 0 && (frame + 1) % hash_every == 0) {
+      std::cout << "frame " << frame + 1 << ' ' << std::hex
+                << hash_console(nes) << std::dec << '\n';
+    }
+  }
+
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << movie.get_frame_count() << " frames in " << elapsed.count()
+            << " s, " << movie.get_frame_count() / elapsed.count()
+            << " fps, final state " << std::hex << hash_console(nes)
+            << std::dec << '\n';
+}
+
+auto replay_netplay(const Cartridge &cartridge, const Movie &movie,
+                    bool is_video, int latency_ms) -> int {
+  const size_t frames = movie.get_frame_count();
+  auto ends = LoopbackTransport::create_pair(
+      std::chrono::milliseconds(latency_ms));
+
+  // every peer owns a console, cartridge included
+  std::array<Bus, 2> peers;
+  for (auto &nes : peers) {
+    nes.insert_cartridge(cartridge.clone());
+    movie.restore_start(nes);
+    nes.m_ppu->set_pixel_output(is_video);
+  }
+  RollbackSession first(peers[0], std::move(ends.first), 0);
+  RollbackSession second(peers[1], std::move(ends.second), 1);
+  std::array<RollbackSession *, 2> sessions{&first, &second};
+
+  FramePacer pacer;
+  while (first.get_frame() < frames || second.get_frame() < frames) {
+    for (uint8_t port = 0; port < 2; port++) {
+      RollbackSession &session = *sessions[port];
+      if (session.get_frame() < frames) {
+        session.advance(movie.get_input(session.get_frame())[port], is_video);
+      }
+    }
+    pacer.wait();
+  }
+
+  // the last inputs are still on their way
+  while (first.get_confirmed_frame() < frames ||
+         second.get_confirmed_frame() < frames) {
+    first.poll();
+    second.poll();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  for (uint8_t port = 0; port < 2; port++) {
+    const auto statistics = sessions[port]->get_statistics();
+    std::cout << "peer " << int(port) << ": " << statistics.rollbacks
+              << " rollbacks, " << statistics.resimulated_frames
+              << " frames re-run, longest " << statistics.max_rollback_frames
+              << " frames in " << statistics.max_rollback_ms << " ms, "
+              << statistics.stalls << " stalls, final state " << std::hex
+              << hash_console(peers[port]) << std::dec << '\n';
+  }
+  return hash_console(peers[0]) == hash_console(peers[1]) ? 0 : 1;
+}
+
+auto replay_batch(const Cartridge &cartridge, const Movie &movie,
+                  bool is_video, size_t instances, size_t threads) -> int {
+  BatchRunner runner(cartridge, instances, threads);
+  for (size_t i = 0; i < instances; i++) {
+    movie.restore_start(runner.get_instance(i));
+  }
+
+  std::vector<BatchRunner::Input> inputs(instances);
+  const auto start = std::chrono::steady_clock::now();
+
+  for (size_t frame = 0; frame < movie.get_frame_count(); frame++) {
+    inputs.assign(instances, movie.get_input(frame));
+    runner.step(inputs, 1, is_video);
+  }
+
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  const double frames = double(movie.get_frame_count()) * instances;
+  std::cout << instances << " consoles on " << threads << " threads: "
+            << frames << " frames in " << elapsed.count() << " s, "
+            << frames / elapsed.count() << " fps in total\n";
+
+  const uint64_t hash = hash_console(runner.get_instance(0));
+  for (size_t i = 1; i < instances; i++) {
+    if (hash_console(runner.get_instance(i)) != hash) {
+      std::cerr << "console " << i << " desynced\n";
+      return 1;
+    }
+  }
+  std::cout << "final state " << std::hex << hash << std::dec << '\n';
+  return 0;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    return usage();
+  }
+
+  bool is_video = true;
+  size_t hash_every = 0;
+  int latency_ms = -1;
+  size_t instances = 0;
+  size_t threads = std::thread::hardware_concurrency();
+  for (int i = 3; i < argc; i++) {
+    if (std::strcmp(argv[i], "--no-video") == 0) {
+      is_video = false;
+    } else if (std::strcmp(argv[i], "--hash-every") == 0 && i + 1 < argc) {
+      hash_every = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--netplay-latency") == 0 &&
+               i + 1 < argc) {
+      latency_ms = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+      instances = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--index") == 0 && i + 1 < argc) {
+      auto database = std::make_shared<RomDatabase>();
+      if (!database->read_file(argv[++i])) {
+        std::cerr << "unable to read ROM index " << argv[i] << '\n';
+        return 1;
+      }
+      RomCache::set_database(database);
+    } else {
+      return usage();
+    }
+  }
+
+  auto cartridge = std::make_shared<Cartridge>(argv[1]);
+  if (!cartridge->is_valid_image()) {
+    std::cerr << "unable to load " << argv[1] << '\n';
+    return 1;
+  }
+
+  Movie movie;
+  if (!Movie::read_file(argv[2], movie)) {
+    std::cerr << "unable to read movie " << argv[2] << '\n';
+    return 1;
+  }
+
+  Bus nes;
+  nes.insert_cartridge(cartridge);
+  if (!movie.restore_start(nes)) {
+    std::cerr << "the movie was recorded on another game\n";
+    return 1;
+  }
+
+  if (latency_ms >= 0) {
+    return replay_netplay(*cartridge, movie, is_video, latency_ms);
+  }
+  if (instances > 0) {
+    return replay_batch(*cartridge, movie, is_video, instances, threads);
+  }
+
+  nes.m_ppu->set_pixel_output(is_video);
+  replay(nes, movie, hash_every);
+  return 0;
+}
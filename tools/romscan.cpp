@@ -0,0 +1,98 @@
+// Indexes a ROM library by the checksums of its dumps, for the emulator to
+// correct bad headers from when it loads a ROM:
+//
+//   NESDebRomScan <directory> <index> [--threads T] [--list-fixes]
+//
+// An existing index is updated in place; only files whose size or
+// modification time changed since are read again. --list-fixes prints every
+// file whose header disagrees with the best one found for the same dump.
+// Gzipped and zipped ROMs are indexed by the ROM they hold.
+
+#include "../include/Mappers.hpp"
+#include "../include/RomDatabase.hpp"
+#include "../include/ThreadPool.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace {
+auto usage() -> int {
+  std::cerr << "usage: NESDebRomScan <directory> <index> [--threads T] "
+               "[--list-fixes]\n";
+  return 2;
+}
+
+auto print_fixes(const RomDatabase &database) -> void {
+  static const char *names[] = {"mapper",  "submapper", "mirroring",
+                                "battery", "RAM sizes", "timing"};
+
+  for (const auto &entry : database.get_entries()) {
+    if (entry.fixes == 0) {
+      continue;
+    }
+    std::cout << std::hex << std::setw(8) << std::setfill('0') << entry.crc32
+              << std::dec << ' ' << entry.path << ':';
+    for (size_t bit = 0; bit < 6; bit++) {
+      if (entry.fixes & (1 << bit)) {
+        std::cout << ' ' << names[bit];
+      }
+    }
+    std::cout << '\n';
+  }
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    return usage();
+  }
+
+  size_t threads = std::thread::hardware_concurrency();
+  bool is_listing_fixes = false;
+  for (int i = 3; i < argc; i++) {
+    if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--list-fixes") == 0) {
+      is_listing_fixes = true;
+    } else {
+      return usage();
+    }
+  }
+
+  // a missing index is a first scan, not an error
+  RomDatabase database;
+  database.read_file(argv[2]);
+
+  const auto start = std::chrono::steady_clock::now();
+  ThreadPool pool(threads);
+  const auto statistics = database.scan(argv[1], pool);
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  if (!database.write_file(argv[2])) {
+    std::cerr << "unable to write index " << argv[2] << '\n';
+    return 1;
+  }
+
+  size_t fixes = 0;
+  size_t unsupported = 0;
+  for (const auto &entry : database.get_entries()) {
+    fixes += entry.fixes != 0;
+    unsupported += !MapperFactory::is_supported(entry.descriptor.mapper_id);
+  }
+  std::cout << statistics.files << " files in " << elapsed.count() << " s: "
+            << statistics.hashed << " hashed, " << statistics.reused
+            << " unchanged, " << statistics.rejected << " rejected, " << fixes
+            << " with headers to fix, " << unsupported
+            << " on mappers the emulator lacks\n";
+
+  if (is_listing_fixes) {
+    print_fixes(database);
+  }
+  return 0;
+}